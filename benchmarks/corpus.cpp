@@ -0,0 +1,257 @@
+/**
+ * Replay corpus benchmark.
+ * Plays back every replay in the corpus directory without any user interface
+ * and measures the simulation speed, the heap allocations per tick and the
+ * peak heap usage. The results are compared against a stored baseline.
+ * In the instrumentation build, it also breaks the allocations down by phase.
+ *
+ * Usage: shitbrix-bench-corpus [corpus directory] [baseline file] [tolerance %] [--update]
+ *
+ * With --update, the results replace the baseline instead of being checked.
+ * The exit code is 1 if any replay does not reproduce or allocates more than
+ * its baseline by more than the tolerance. The speed depends on the machine,
+ * so the comparison of ticks/s is only shown, never checked.
+ */
+
+#include "game.hpp"
+#include "director.hpp"
+#include "allocation.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const char* DEFAULT_DIRECTORY = "benchmarks/corpus";
+const char* DEFAULT_BASELINE = "benchmarks/corpus_baseline.txt";
+const double DEFAULT_TOLERANCE = 10; //!< permitted regression in percent
+const int MIN_REPETITIONS = 3; //!< playbacks per replay, of which the fastest counts
+const double MIN_SECONDS = 1; //!< repeat short replays until they have run this long in total
+const long MAX_TICKS = 60 * 60 * TPS; //!< upper limit on the length of one playback
+
+/**
+ * Performance figures of one replay.
+ */
+struct Measurement
+{
+	long ticks = 0;
+	double ticks_per_second = 0;
+	double allocations_per_tick = 0;
+	long peak_kib = 0; //!< heap usage above the level before the playback
+	AllocationCounts allocations; //!< allocations by phase during the playback
+};
+
+/**
+ * Load the replay and play it back to the end of the game.
+ * The load time does not count towards the measurement.
+ */
+Measurement play_replay(const std::filesystem::path& path)
+{
+	Measurement best;
+	double total_seconds = 0;
+
+	for(int i = 0; i < MIN_REPETITIONS || total_seconds < MIN_SECONDS; i++) {
+		LocalGame game{std::make_unique<LocalGameFactory>()};
+		game.load_replay(path);
+
+		reset_allocation_peak();
+		const AllocationCounts before = allocation_counts();
+		const auto start = std::chrono::steady_clock::now();
+
+		for(long time = 1; time <= MAX_TICKS && !game.director().over(); time++)
+			game.synchronurse(time);
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		const AllocationCounts allocations = allocation_counts().since(before);
+		const long ticks = game.state().game_time();
+		const double ticks_per_second = ticks / elapsed.count();
+		total_seconds += elapsed.count();
+
+		if(ticks_per_second > best.ticks_per_second) {
+			best.ticks = ticks;
+			best.ticks_per_second = ticks_per_second;
+			best.allocations_per_tick = static_cast<double>(allocations.total()) / ticks;
+			best.peak_kib = (allocations.peak_bytes - before.bytes) / 1024;
+			best.allocations = allocations;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Read the baseline file: one line per replay with name, ticks, ticks/s,
+ * allocations per tick and peak heap usage.
+ */
+std::map<std::string, Measurement> read_baseline(const std::filesystem::path& path)
+{
+	std::map<std::string, Measurement> baseline;
+	std::ifstream stream{path};
+	std::string line;
+
+	while(std::getline(stream, line)) {
+		if(line.empty() || '#' == line[0])
+			continue;
+
+		std::istringstream tokens{line};
+		std::string name;
+		Measurement measurement;
+		tokens >> name >> measurement.ticks >> measurement.ticks_per_second >> measurement.allocations_per_tick >> measurement.peak_kib;
+		enforce(!tokens.fail());
+		baseline[name] = measurement;
+	}
+
+	return baseline;
+}
+
+void write_baseline(const std::filesystem::path& path, const std::map<std::string, Measurement>& results)
+{
+	std::ofstream stream{path};
+	enforce(stream.good());
+	stream << "# replay ticks ticks/s allocs/tick peak-KiB\n";
+	for(const auto& [name, measurement] : results) {
+		stream << name << ' ' << measurement.ticks << ' ' << static_cast<long>(measurement.ticks_per_second) << ' '
+			<< measurement.allocations_per_tick << ' ' << measurement.peak_kib << '\n';
+	}
+}
+
+/**
+ * Return the relative change from the baseline value in percent.
+ */
+double change(double value, double base) noexcept
+{
+	return base > 0 ? 100. * (value - base) / base : 0.;
+}
+
+/**
+ * Compare the machine-independent figures of the measurement to its baseline
+ * and print the outcome. Return true if they are within the tolerance.
+ */
+bool check(const std::string& name, const Measurement& measurement, const Measurement& base, double tolerance)
+{
+	bool ok = true;
+
+	if(measurement.ticks != base.ticks) {
+		std::printf("  %s: played %ld ticks, baseline %ld -- the replay does not reproduce\n", name.c_str(), measurement.ticks, base.ticks);
+		ok = false;
+	}
+
+	const double allocations = change(measurement.allocations_per_tick, base.allocations_per_tick);
+	const double peak = change(static_cast<double>(measurement.peak_kib), static_cast<double>(base.peak_kib));
+
+	if(allocations > tolerance) {
+		std::printf("  %s: allocs/tick %+.1f%%\n", name.c_str(), allocations);
+		ok = false;
+	}
+	if(peak > tolerance) {
+		std::printf("  %s: peak heap %+.1f%%\n", name.c_str(), peak);
+		ok = false;
+	}
+
+	return ok;
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	on_failure_break_into_debugger = false; // report errors on the console instead
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	const auto update_flag = std::find(args.begin(), args.end(), "--update");
+	const bool update = args.end() != update_flag;
+	if(update)
+		args.erase(update_flag);
+
+	try {
+		// The log goes nowhere, so formatting trace messages would only distort the allocation counts.
+		Configuration configuration;
+		configuration.log_level = Log::Level::ERR;
+		configure_headless_context(configuration, create_no_log());
+
+		const std::filesystem::path directory = args.size() > 0 ? args[0] : DEFAULT_DIRECTORY;
+		const std::filesystem::path baseline_path = args.size() > 1 ? args[1] : DEFAULT_BASELINE;
+		const double tolerance = args.size() > 2 ? std::stod(args[2]) : DEFAULT_TOLERANCE;
+
+		std::vector<std::filesystem::path> replays;
+		for(const auto& entry : std::filesystem::directory_iterator(directory)) {
+			if(".txt" == entry.path().extension())
+				replays.push_back(entry.path());
+		}
+		std::sort(replays.begin(), replays.end());
+		enforce(!replays.empty());
+
+		const auto baseline = update ? std::map<std::string, Measurement>{} : read_baseline(baseline_path);
+		std::map<std::string, Measurement> results;
+		bool ok = true;
+
+		std::printf("%-12s %8s %10s %12s %10s %10s\n", "replay", "ticks", "ticks/s", "allocs/tick", "peak KiB", "speed");
+
+		for(const auto& path : replays) {
+			const std::string name = path.stem().u8string();
+			const Measurement measurement = play_replay(path);
+			results[name] = measurement;
+
+			const auto base = baseline.find(name);
+			std::string versus = "-";
+			if(baseline.end() != base) {
+				char text[16];
+				std::snprintf(text, sizeof(text), "%+.1f%%", change(measurement.ticks_per_second, base->second.ticks_per_second));
+				versus = text;
+			}
+
+			std::printf("%-12s %8ld %10.0f %12.2f %10ld %10s\n", name.c_str(), measurement.ticks,
+				measurement.ticks_per_second, measurement.allocations_per_tick, measurement.peak_kib, versus.c_str());
+		}
+
+#if defined(SHITBRIX_COUNT_ALLOCATIONS)
+		std::printf("\nAllocations per tick by phase:\n%-12s", "replay");
+		for(size_t i = 0; i < ALLOC_PHASES; i++)
+			std::printf(" %10s", alloc_phase_name(static_cast<AllocPhase>(i)));
+		std::printf("\n");
+
+		for(const auto& [name, measurement] : results) {
+			std::printf("%-12s", name.c_str());
+			for(long count : measurement.allocations.allocations)
+				std::printf(" %10.2f", static_cast<double>(count) / measurement.ticks);
+			std::printf("\n");
+		}
+		std::printf("\n");
+#endif
+
+		if(update) {
+			write_baseline(baseline_path, results);
+			std::printf("Baseline written to %s.\n", baseline_path.u8string().c_str());
+			return 0;
+		}
+
+		std::printf("Speed is relative to the baseline machine and not checked.\n");
+		std::printf("Regressions in allocations beyond %.0f%%:\n", tolerance);
+		for(const auto& [name, measurement] : results) {
+			const auto base = baseline.find(name);
+			if(baseline.end() == base)
+				std::printf("  %s: no baseline\n", name.c_str());
+			else
+				ok = check(name, measurement, base->second, tolerance) && ok;
+		}
+
+		if(ok)
+			std::printf("  none\n");
+
+		return ok ? 0 : 1;
+	}
+	catch(const std::exception& ex) {
+		std::fprintf(stderr, "%s\n", ex.what());
+		return 2;
+	}
+}
@@ -0,0 +1,282 @@
+/**
+ * Network conditions benchmark.
+ * A server and two clients play in memory, each client controlled by a
+ * computer player. The links between the clients and the server suffer from
+ * the network conditions of several profiles, from perfect to awful. Time is
+ * simulated, so the games run as fast as the machine can calculate them.
+ * Every profile runs without input delay and with the adaptive input delay.
+ * Reports how often and how deeply the server and the clients roll back,
+ * how many retract messages the server sends and the CPU time per tick.
+ *
+ * Usage: shitbrix-bench-network [games] [first seed]
+ */
+
+#include "game.hpp"
+#include "agent.hpp"
+#include "network.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int DEFAULT_GAMES = 3;
+const unsigned DEFAULT_SEED = 1;
+const int AGENT_DELAY = 2; //!< reaction time of the strongest computer player
+const long MAX_TICKS = 3 * 60 * TPS; //!< upper limit on the length of one game
+const int POLLS_PER_TICK = 4; //!< message handling between ticks, like the server loop
+const int CLIENTS = 2;
+
+/**
+ * A named set of network conditions.
+ */
+struct Profile
+{
+	const char* name;
+	NetConditions conditions; //!< on every link between a client and the server
+};
+
+const Profile PROFILES[] =
+{
+	//                latency jitter loss dupl. reord.
+	{"perfect",     {  0,       0,    0,   0,    0}},
+	{"lan",         {  2,       1,    0,   0,    0}},
+	{"broadband",   { 20,       5,    1,   0,    1}},
+	{"wifi",        { 40,      20,    2,   1,    5}},
+	{"mobile",      { 80,      40,    5,   2,   10}},
+	{"awful",       {150,     100,   15,   5,   20}},
+};
+
+/**
+ * One end of an in-memory link. Sent messages wait at the other ends.
+ */
+class MemoryChannel : public IChannel
+{
+
+public:
+
+	void connect(MemoryChannel& peer) { m_peers.push_back(&peer); }
+
+	virtual void send(Message message) override
+	{
+		for(MemoryChannel* peer : m_peers)
+			peer->m_buffer.push_back(message);
+	}
+
+	virtual std::vector<Message> poll() override
+	{
+		std::vector<Message> messages;
+		swap(m_buffer, messages);
+		return messages;
+	}
+
+private:
+
+	std::vector<Message> m_buffer; //!< received messages
+	std::vector<MemoryChannel*> m_peers; //!< recipients of sent messages
+
+};
+
+/**
+ * Passes messages through and counts the retractions among them.
+ */
+class RetractCounter : public IChannel
+{
+
+public:
+
+	explicit RetractCounter(std::unique_ptr<IChannel> channel, long& retracts)
+		: m_channel(move(channel)), m_retracts(&retracts)
+	{}
+
+	virtual void send(Message message) override
+	{
+		if(MsgType::RETRACT == message.type)
+			(*m_retracts)++;
+
+		m_channel->send(std::move(message));
+	}
+
+	virtual std::vector<Message> poll() override { return m_channel->poll(); }
+
+private:
+
+	std::unique_ptr<IChannel> m_channel;
+	long* m_retracts;
+
+};
+
+/**
+ * Results of one or more games under the same conditions.
+ */
+struct Measurement
+{
+	long ticks = 0;
+	RollbackStats server;
+	RollbackStats clients; //!< sum over all clients
+	long retracts = 0;
+	double seconds = 0;
+
+	void add(const RollbackStats& lhs, RollbackStats& rhs) const
+	{
+		rhs.rollbacks += lhs.rollbacks;
+		rhs.ticks += lhs.ticks;
+		rhs.max_depth = std::max(rhs.max_depth, lhs.max_depth);
+	}
+};
+
+/**
+ * A game participant with its own clock, which starts at the game start.
+ */
+struct Participant
+{
+	IGame* game;
+	long tick = 0; //!< ticks since the game start, including the intro
+
+	/**
+	 * Advance by one tick. After the intro, run the game logic.
+	 */
+	void update()
+	{
+		if(!game->switches().ingame)
+			return;
+
+		tick++;
+		if(tick > INTRO_TIME)
+			game->synchronurse(tick - INTRO_TIME);
+	}
+};
+
+/**
+ * Play one networked game to its end and add the results to the measurement.
+ */
+void play_game(const NetConditions& conditions, const Rules& rules, unsigned seed, Measurement& measurement)
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point now{};
+	const NetClock clock = [&now] { return now; };
+
+	auto server_channel = std::make_unique<MemoryChannel>();
+	std::vector<std::unique_ptr<MemoryChannel>> client_channels;
+	for(int i = 0; i < CLIENTS; i++) {
+		client_channels.push_back(std::make_unique<MemoryChannel>());
+		server_channel->connect(*client_channels.back());
+		client_channels.back()->connect(*server_channel);
+	}
+
+	long retracts = 0;
+	auto server_protocol = std::make_unique<ServerProtocol>(std::make_unique<RetractCounter>(move(server_channel), retracts));
+	auto server_factory = std::make_unique<ServerGameFactory>(*server_protocol);
+	ServerGame server{move(server_factory), move(server_protocol)};
+	server.set_seed(seed);
+
+	std::vector<std::unique_ptr<ClientGame>> clients;
+	std::vector<std::unique_ptr<Agent>> agents;
+	for(int i = 0; i < CLIENTS; i++) {
+		auto channel = make_conditioned_channel(move(client_channels[i]), conditions, seed * CLIENTS + i, clock);
+		auto protocol = std::make_unique<ClientProtocol>(move(channel));
+		clients.push_back(std::make_unique<ClientGame>(std::make_unique<ClientGameFactory>(), move(protocol)));
+		agents.push_back(std::make_unique<Agent>(clients.back()->snapshot(), i, AGENT_DELAY));
+	}
+
+	std::vector<Participant> participants{Participant{&server}};
+	for(auto& client : clients)
+		participants.push_back(Participant{client.get()});
+
+	for(Participant& participant : participants)
+		participant.game->after_start([&participant] { participant.tick = 0; });
+
+	// the first client takes the lead, like a player in the pregame screen
+	clients[0]->game_reset(2, rules, false);
+	clients[0]->game_start();
+
+	const auto start = Clock::now();
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{1}) / TPS;
+
+	while(NOONE == server.switches().winner && participants[0].tick < MAX_TICKS + INTRO_TIME) {
+		for(int i = 0; i < CLIENTS; i++) {
+			if(participants[i + 1].tick >= INTRO_TIME) {
+				agents[i]->set_input_delay(clients[i]->input_delay());
+				for(const PlayerInput pi : agents[i]->move())
+					clients[i]->game_input(Input{pi});
+			}
+		}
+
+		for(int p = 0; p < POLLS_PER_TICK; p++) {
+			now += period / POLLS_PER_TICK;
+			for(auto& client : clients)
+				client->poll();
+			server.poll();
+		}
+
+		for(Participant& participant : participants)
+			participant.update();
+	}
+
+	const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+	for(Participant& participant : participants)
+		participant.game->after_start(nullptr);
+
+	measurement.ticks += participants[0].tick;
+	measurement.seconds += elapsed.count();
+	measurement.retracts += retracts;
+	measurement.add(server.rollback_stats(), measurement.server);
+	for(auto& client : clients)
+		measurement.add(client->rollback_stats(), measurement.clients);
+}
+
+/**
+ * Format the rollback figures as count, average depth and maximum depth.
+ */
+std::string format_rollbacks(const RollbackStats& stats)
+{
+	char text[64];
+	const double average = stats.rollbacks > 0 ? static_cast<double>(stats.ticks) / stats.rollbacks : 0.;
+	std::snprintf(text, sizeof(text), "%7ld %6.1f %4ld", stats.rollbacks, average, stats.max_depth);
+	return text;
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	on_failure_break_into_debugger = false; // report errors on the console instead
+
+	try {
+		configure_headless_context(Configuration{}, create_no_log());
+
+		const int games = argc > 1 ? std::stoi(argv[1]) : DEFAULT_GAMES;
+		const unsigned seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : DEFAULT_SEED;
+
+		std::printf("%d games per profile, rollbacks: count, average and maximum depth in ticks\n\n", games);
+		std::printf("%-10s %-5s %7s  %-20s %-20s %8s %8s\n", "profile", "delay", "ticks", "server rollbacks", "client rollbacks", "retracts", "us/tick");
+
+		for(const Profile& profile : PROFILES) {
+			for(const int input_delay : {0, INPUT_DELAY_AUTO}) {
+				Rules rules;
+				rules.input_delay = input_delay;
+				Measurement measurement;
+
+				for(int i = 0; i < games; i++)
+					play_game(profile.conditions, rules, seed + i, measurement);
+
+				std::printf("%-10s %-5s %7ld  %-20s %-20s %8ld %8.1f\n", profile.name, INPUT_DELAY_AUTO == input_delay ? "auto" : "none",
+					measurement.ticks, format_rollbacks(measurement.server).c_str(), format_rollbacks(measurement.clients).c_str(),
+					measurement.retracts, 1e6 * measurement.seconds / measurement.ticks);
+			}
+		}
+	}
+	catch(const std::exception& ex) {
+		std::fprintf(stderr, "%s\n", ex.what());
+		return 1;
+	}
+
+	return 0;
+}
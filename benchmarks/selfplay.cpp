@@ -0,0 +1,84 @@
+/**
+ * Self-play benchmark.
+ * Two computer players play local games with fixed seeds, so that every run
+ * simulates exactly the same ticks. Reports the simulation speed.
+ *
+ * Usage: shitbrix-bench-selfplay [games] [first seed]
+ */
+
+#include "game.hpp"
+#include "director.hpp"
+#include "agent.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+const int DEFAULT_GAMES = 10;
+const unsigned DEFAULT_SEED = 1;
+const int AGENT_DELAY = 2; //!< reaction time of the strongest computer player
+const long MAX_TICKS = 10 * 60 * TPS; //!< upper limit on the length of one game
+
+/**
+ * Play one game to its end and return the number of ticks that it lasted.
+ */
+long play_game(LocalGame& game, unsigned seed)
+{
+	game.set_seed(seed);
+	game.game_reset(2, Rules{}, false);
+	game.game_start();
+
+	Agent agent0{game.snapshot(), 0, AGENT_DELAY};
+	Agent agent1{game.snapshot(), 1, AGENT_DELAY};
+
+	for(long time = 1; time <= MAX_TICKS && !game.director().over(); time++) {
+		for(Agent* agent : {&agent0, &agent1}) {
+			for(const PlayerInput pi : agent->move())
+				game.game_input(Input{pi});
+		}
+
+		game.synchronurse(time);
+	}
+
+	return game.state().game_time();
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	on_failure_break_into_debugger = false; // report errors on the console instead
+
+	try {
+		configure_headless_context(Configuration{}, create_no_log());
+
+		const int games = argc > 1 ? std::stoi(argv[1]) : DEFAULT_GAMES;
+		const unsigned seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : DEFAULT_SEED;
+
+		LocalGame game{std::make_unique<LocalGameFactory>()};
+		long ticks = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for(int i = 0; i < games; i++)
+			ticks += play_game(game, seed + i);
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::printf("games:   %d\n", games);
+		std::printf("ticks:   %ld\n", ticks);
+		std::printf("seconds: %.3f\n", elapsed.count());
+		std::printf("ticks/s: %.0f\n", ticks / elapsed.count());
+	}
+	catch(const std::exception& ex) {
+		std::fprintf(stderr, "%s\n", ex.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,390 @@
+/**
+ * Determinism check over rollbacks, see determinism.hpp.
+ * This file also provides the libFuzzer entry point.
+ */
+
+#include "determinism.hpp"
+#include "game.hpp"
+#include "director.hpp"
+#include "arbiter.hpp"
+#include "replay.hpp"
+#include "state.hpp"
+#include "event.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+const long MAX_TICKS = 10 * 60 * TPS; //!< upper limit on the length of a scenario
+const long MAX_DELAY = 2 * CHECKPOINT_INTERVAL; //!< latest arrival of a late input, in ticks
+const int LATE_CHANCE = 8; //!< one in this many inputs arrives late
+
+/**
+ * Sequential access to the fuzz data.
+ * Once the data is exhausted, every read returns 0.
+ */
+class FuzzReader
+{
+
+public:
+
+	explicit FuzzReader(const uint8_t* data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+	bool done() const noexcept { return m_pos >= m_size; }
+	uint8_t next() noexcept { return done() ? 0 : m_data[m_pos++]; }
+
+private:
+
+	const uint8_t* m_data;
+	size_t m_size;
+	size_t m_pos = 0;
+
+};
+
+/**
+ * Takes the colors of spawned blocks and garbage loot from the fuzz data.
+ */
+class FuzzColorSupplier : public IColorSupplier
+{
+
+public:
+
+	explicit FuzzColorSupplier(FuzzReader& reader) noexcept : m_reader(&reader) {}
+
+	virtual Color next_spawn() noexcept override { return static_cast<Color>(1 + m_reader->next() % 6); }
+	virtual Color next_emerge() noexcept override { return next_spawn(); }
+	virtual std::unique_ptr<IColorSupplier> clone() const override { return std::make_unique<FuzzColorSupplier>(*this); }
+
+private:
+
+	FuzzReader* m_reader;
+
+};
+
+/**
+ * Creates a local game with an arbiter that decides according to the fuzz data.
+ */
+class FuzzGameFactory : public IGameFactory
+{
+
+public:
+
+	explicit FuzzGameFactory(FuzzReader& reader) noexcept : m_reader(&reader) {}
+
+	virtual void create(GameMeta meta) override
+	{
+		base_create(meta);
+
+		if(!meta.replay) {
+			m_arbiter = std::make_unique<LocalArbiter>(*m_state, *m_journal, std::make_unique<FuzzColorSupplier>(*m_reader));
+			m_hub->subscribe(*m_arbiter);
+		}
+	}
+
+private:
+
+	FuzzReader* m_reader;
+
+};
+
+/**
+ * Records the stream of game events in a comparable form.
+ * When the game rolls back, the events from the obsolete time line are discarded.
+ */
+class EventRecord : public evt::IEventObserver
+{
+
+public:
+
+	// type, time, player, details
+	using Entry = std::tuple<int, long, int, int, int>;
+
+	const std::vector<Entry>& entries() const noexcept { return m_entries; }
+
+	/**
+	 * Discard all events after the given time.
+	 */
+	void truncate(long game_time)
+	{
+		while(!m_entries.empty() && std::get<1>(m_entries.back()) > game_time)
+			m_entries.pop_back();
+	}
+
+	virtual void fire(evt::CursorMoves e) override { add(0, e.trivia); }
+	virtual void fire(evt::Swap e) override { add(1, e.trivia); }
+	virtual void fire(evt::Match e) override { add(2, e.trivia, e.combo, e.chaining); }
+	virtual void fire(evt::Chain e) override { add(3, e.trivia, e.counter); }
+	virtual void fire(evt::PhysicalLands e) override { add(4, e.trivia, e.physical.rc().r, e.physical.rc().c); }
+	virtual void fire(evt::BlockDies e) override { add(5, e.trivia); }
+	virtual void fire(evt::GarbageDissolves e) override { add(6, e.trivia); }
+	virtual void fire(evt::Starve e) override { add(7, e.trivia, e.row); }
+
+private:
+
+	void add(int type, evt::Trivia trivia, int a = 0, int b = 0)
+	{
+		m_entries.emplace_back(type, trivia.game_time, trivia.player, a, b);
+	}
+
+	std::vector<Entry> m_entries;
+
+};
+
+/**
+ * Plays back a scenario of inputs, which may arrive at any time.
+ * Unlike @c LocalGame, this game accepts rollbacks.
+ */
+class RollbackGame : public IGame
+{
+
+public:
+
+	explicit RollbackGame() : IGame(std::make_unique<LocalGameFactory>()) {}
+
+	int rollbacks() const noexcept { return m_rollbacks; }
+	const EventRecord& events() const noexcept { return m_events; }
+
+	virtual void game_start() override
+	{
+		base_start();
+		m_hub->subscribe(m_events);
+	}
+
+	virtual void game_input(Input input) override { m_journal->add_input(std::move(input)); }
+
+	virtual void game_reset(int players, Rules rules, bool replay) override
+	{
+		base_reset();
+		m_meta = GameMeta{players, 0, true, rules, NOONE};
+	}
+
+	virtual void set_speed(int ) override {}
+	virtual void poll() override {}
+
+protected:
+
+	virtual void before_rollback(long , long checkpoint_time) override
+	{
+		m_rollbacks++;
+		m_events.truncate(checkpoint_time);
+	}
+
+private:
+
+	int m_rollbacks = 0;
+	EventRecord m_events;
+
+};
+
+/**
+ * Hold, release and press buttons like a player would.
+ */
+class FuzzPlayers
+{
+
+public:
+
+	/**
+	 * Decode one command from the fuzz data and give the resulting inputs
+	 * for the given time to the game.
+	 */
+	void act(FuzzReader& reader, IGame& game, long game_time)
+	{
+		const uint8_t command = reader.next();
+		const int player = (command / 16) % 2;
+		const int kind = command % 16;
+
+		if(kind <= 5) { // release the held button, then maybe press another
+			release(game, game_time, player);
+
+			if(kind < 5) {
+				const GameButton buttons[] = {GameButton::LEFT, GameButton::RIGHT, GameButton::UP, GameButton::DOWN, GameButton::SWAP};
+				m_held[player] = buttons[kind];
+				game.game_input(Input{PlayerInput{game_time, player, m_held[player], ButtonAction::DOWN}});
+			}
+		}
+		else if(6 == kind) { // raise the pit until the next release
+			release(game, game_time, player);
+			m_held[player] = GameButton::RAISE;
+			game.game_input(Input{PlayerInput{game_time, player, GameButton::RAISE, ButtonAction::DOWN}});
+		}
+		else if(7 == kind && game_time > INTRO_TIME) { // drop garbage into the filled pit
+			const uint8_t shape = reader.next();
+			const int columns = 3 + shape % 4;
+			const int rows = 1 + (shape / 4) % 3;
+			Loot loot(static_cast<size_t>(columns) * rows);
+			for(Color& color : loot)
+				color = static_cast<Color>(1 + reader.next() % 6);
+			game.game_input(Input{SpawnGarbageInput{game_time, player, rows, columns, std::move(loot)}});
+		}
+		// else do nothing in this tick
+	}
+
+private:
+
+	void release(IGame& game, long game_time, int player)
+	{
+		if(GameButton::NONE != m_held[player])
+			game.game_input(Input{PlayerInput{game_time, player, m_held[player], ButtonAction::UP}});
+
+		m_held[player] = GameButton::NONE;
+	}
+
+	GameButton m_held[2] = {GameButton::NONE, GameButton::NONE};
+
+};
+
+/**
+ * Hash of the fuzz data to seed the choice of late inputs.
+ */
+unsigned fnv_hash(const uint8_t* data, size_t size) noexcept
+{
+	unsigned hash = 2166136261u;
+	for(size_t i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+	return hash;
+}
+
+/**
+ * Return a description of the first difference between the two games, if any.
+ */
+std::optional<std::string> compare(const char* what, IGame& lhs, const EventRecord* lhs_events,
+                                   IGame& rhs, const EventRecord* rhs_events)
+{
+	if(const auto diff = lhs.state().diff(rhs.state()))
+		return std::string(what) + ": " + diff->to_string();
+
+	if(lhs.director().winner() != rhs.director().winner())
+		return std::string(what) + ": winner " + std::to_string(lhs.director().winner()) + " != " + std::to_string(rhs.director().winner());
+
+	if(lhs_events && rhs_events && lhs_events->entries() != rhs_events->entries()) {
+		const auto& l = lhs_events->entries();
+		const auto& r = rhs_events->entries();
+		size_t i = 0;
+		while(i < l.size() && i < r.size() && l[i] == r[i])
+			i++;
+		const long time = i < l.size() ? std::get<1>(l[i]) : std::get<1>(r[i]);
+		return std::string(what) + ": events differ at #" + std::to_string(i) + " in tick " + std::to_string(time);
+	}
+
+	return {};
+}
+
+}
+
+void setup_determinism_check()
+{
+	on_failure_break_into_debugger = false;
+	configure_headless_context(Configuration{}, create_no_log());
+}
+
+FuzzResult check_determinism(const uint8_t* data, size_t size)
+{
+	FuzzResult result;
+	const char* phase = "reference";
+
+	try {
+		// Record the scenario in a game driven by the fuzz data.
+		FuzzReader reader{data, size};
+		LocalGame reference{std::make_unique<FuzzGameFactory>(reader)};
+		reference.game_reset(2, Rules{}, false);
+		reference.game_start();
+		EventRecord reference_events;
+		reference.hub().subscribe(reference_events);
+
+		FuzzPlayers players;
+		long end_time = 0;
+		while(!reader.done() && end_time < MAX_TICKS && !reference.director().over()) {
+			end_time++;
+			players.act(reader, reference, end_time);
+			reference.synchronurse(end_time);
+		}
+
+		const Inputs scenario = reference.journal().inputs();
+		result.ticks = end_time;
+		result.inputs = scenario.size();
+
+		// Play the scenario straight through.
+		phase = "straight";
+		RollbackGame straight;
+		straight.game_reset(2, Rules{}, true);
+		straight.game_start();
+		for(const Input& input : scenario)
+			straight.game_input(input);
+		for(long time = 1; time <= end_time; time++)
+			straight.synchronurse(time);
+
+		if(straight.rollbacks() > 0)
+			result.failure = "straight: unexpected rollback";
+		else
+			result.failure = compare("reference/straight", reference, &reference_events, straight, &straight.events());
+
+		if(result.failure)
+			return result;
+
+		// Play the scenario again, but let some inputs arrive late.
+		phase = "late";
+		std::minstd_rand generator{fnv_hash(data, size)};
+		std::uniform_int_distribution<int> late_distribution{0, LATE_CHANCE - 1};
+		std::uniform_int_distribution<long> delay_distribution{1, MAX_DELAY};
+		std::vector<std::pair<long, Input>> deliveries; // arrival time, input
+		std::map<int, long> source_arrival; // like a network channel, every source delivers in order
+		for(const Input& input : scenario) {
+			const long delay = 0 == late_distribution(generator) ? delay_distribution(generator) : 0;
+			long& arrival = source_arrival[input.source()];
+			arrival = std::max(arrival, input.game_time() + delay);
+			deliveries.emplace_back(arrival, input);
+		}
+		std::stable_sort(deliveries.begin(), deliveries.end(),
+			[](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+		RollbackGame late;
+		late.game_reset(2, Rules{}, true);
+		late.game_start();
+		auto next = deliveries.begin();
+		for(long time = 1; time <= end_time; time++) {
+			for(; deliveries.end() != next && next->first <= time; ++next)
+				late.game_input(next->second);
+			late.synchronurse(time);
+		}
+
+		// whatever is still underway arrives after the end
+		for(; deliveries.end() != next; ++next)
+			late.game_input(next->second);
+		late.synchronurse(end_time);
+
+		result.rollbacks = late.rollbacks();
+		result.failure = compare("straight/late", straight, &straight.events(), late, &late.events());
+	}
+	catch(const std::exception& ex) {
+		result.failure = std::string(phase) + ": " + ex.what();
+	}
+
+	return result;
+}
+
+#if defined(SHITBRIX_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	static bool setup = (setup_determinism_check(), true);
+
+	const FuzzResult result = check_determinism(data, size);
+	if(result.failure) {
+		std::fprintf(stderr, "Determinism failure: %s\n", result.failure->c_str());
+		std::abort();
+	}
+
+	return 0;
+}
+
+#endif
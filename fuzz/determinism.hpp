@@ -0,0 +1,39 @@
+/**
+ * determinism.hpp
+ * Property-based check that rollbacks do not change the outcome of a game.
+ *
+ * The fuzz data drives a local game, which records a scenario of player
+ * inputs and arbiter decisions (block spawns and garbage). The scenario then
+ * plays again twice: once with all inputs known in advance, once with some
+ * inputs arriving late, which forces @c IGame::synchronurse to roll back.
+ * Both runs must end in identical states with identical event streams.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * Statistics and outcome of one determinism check.
+ */
+struct FuzzResult
+{
+	long ticks = 0; //!< length of the scenario in ticks
+	size_t inputs = 0; //!< number of inputs in the scenario
+	int rollbacks = 0; //!< number of rollbacks forced by late inputs
+	std::optional<std::string> failure; //!< description of the first mismatch, if any
+};
+
+/**
+ * Prepare the global context for running determinism checks.
+ * Call this once before any check.
+ */
+void setup_determinism_check();
+
+/**
+ * Run one determinism check with the given fuzz data.
+ * Checks in different threads do not interfere with each other.
+ */
+FuzzResult check_determinism(const uint8_t* data, size_t size);
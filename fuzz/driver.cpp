@@ -0,0 +1,141 @@
+/**
+ * Standalone driver for the determinism fuzzer.
+ * Generates random fuzz data and runs the checks on all cores.
+ * Failing inputs are saved to files, which can be passed back to the driver
+ * (or to a libFuzzer build) to reproduce the failure.
+ *
+ * Usage: shitbrix-fuzz [seconds] [seed]
+ *        shitbrix-fuzz <file>...
+ */
+
+#include "determinism.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+const double DEFAULT_SECONDS = 10;
+const size_t MIN_SIZE = 16; //!< smallest generated fuzz data in bytes
+const size_t MAX_SIZE = 8192; //!< largest generated fuzz data in bytes
+
+std::atomic<bool> failed{false};
+std::atomic<long> cases{0};
+std::atomic<long> inputs{0};
+std::atomic<long> ticks{0};
+std::atomic<long> rollbacks{0};
+std::mutex report_mutex;
+
+/**
+ * Write the failing data to a file and describe the failure.
+ */
+void report_failure(const std::vector<uint8_t>& data, const std::string& failure)
+{
+	std::lock_guard<std::mutex> lock{report_mutex};
+
+	const std::string path = "fuzz-failure-" + std::to_string(cases.load()) + ".bin";
+	std::ofstream stream{path, std::ios::binary};
+	stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+	std::fprintf(stderr, "Determinism failure: %s\nInput saved to %s.\n", failure.c_str(), path.c_str());
+	failed = true;
+}
+
+/**
+ * Run checks with random data until the time is up or any check fails.
+ */
+void fuzz_worker(unsigned seed, std::chrono::steady_clock::time_point deadline)
+{
+	std::mt19937 generator{seed};
+	std::uniform_int_distribution<size_t> size_distribution{MIN_SIZE, MAX_SIZE};
+	std::uniform_int_distribution<int> byte_distribution{0, 255};
+	std::vector<uint8_t> data;
+
+	while(!failed && std::chrono::steady_clock::now() < deadline) {
+		data.resize(size_distribution(generator));
+		for(uint8_t& byte : data)
+			byte = static_cast<uint8_t>(byte_distribution(generator));
+
+		const FuzzResult result = check_determinism(data.data(), data.size());
+		cases++;
+		inputs += static_cast<long>(result.inputs);
+		ticks += result.ticks;
+		rollbacks += result.rollbacks;
+
+		if(result.failure)
+			report_failure(data, *result.failure);
+	}
+}
+
+/**
+ * Run the check once for every given file.
+ */
+int reproduce(int count, const char* paths[])
+{
+	int status = 0;
+
+	for(int i = 0; i < count; i++) {
+		std::ifstream stream{paths[i], std::ios::binary};
+		if(!stream) {
+			std::fprintf(stderr, "Cannot read %s.\n", paths[i]);
+			status = 2;
+			continue;
+		}
+
+		const std::vector<uint8_t> data{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+		const FuzzResult result = check_determinism(data.data(), data.size());
+		std::printf("%s: %ld ticks, %zu inputs, %d rollbacks: %s\n", paths[i], result.ticks, result.inputs,
+			result.rollbacks, result.failure ? result.failure->c_str() : "ok");
+
+		if(result.failure)
+			status = 1;
+	}
+
+	return status;
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	setup_determinism_check();
+
+	// file arguments reproduce earlier failures
+	if(argc > 1 && !std::isdigit(static_cast<unsigned char>(argv[1][0])))
+		return reproduce(argc - 1, argv + 1);
+
+	const double seconds = argc > 1 ? std::stod(argv[1]) : DEFAULT_SECONDS;
+	const unsigned seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : std::random_device{}();
+	const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::printf("Fuzzing for %.0f s on %u threads, seed %u.\n", seconds, threads, seed);
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+
+	std::vector<std::thread> workers;
+	for(unsigned i = 0; i < threads; i++)
+		workers.emplace_back(fuzz_worker, seed + i, deadline);
+	for(std::thread& worker : workers)
+		worker.join();
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::printf("cases:     %ld\n", cases.load());
+	std::printf("inputs:    %ld\n", inputs.load());
+	std::printf("ticks:     %ld\n", ticks.load());
+	std::printf("rollbacks: %ld\n", rollbacks.load());
+	std::printf("inputs/s:  %.0f\n", inputs / elapsed.count());
+	std::printf("cases/s:   %.1f\n", cases / elapsed.count());
+
+	return failed ? 1 : 0;
+}
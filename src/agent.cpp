@@ -242,7 +242,7 @@ size_t MovePossiblity::translate_rc(const RowCol rc) const
 
 
 Agent::Agent(const GameState& state, const int pit, const int delay)
-	: m_state(&state), m_pit(pit), m_delay(delay), m_last_time(-delay - 1)
+	: m_snapshot(nullptr), m_state(&state), m_pit(pit), m_delay(delay), m_last_time(-delay - 1)
 {
 	enforce(pit >= 0);
 	enforce(pit < state.pit().size());
@@ -251,13 +251,50 @@ Agent::Agent(const GameState& state, const int pit, const int delay)
 	Log::info("Agent: active as player %d, delay: %d", pit, delay);
 }
 
+Agent::Agent(const SnapshotHandle& snapshot, const int pit, const int delay)
+	: m_snapshot(&snapshot), m_state(nullptr), m_pit(pit), m_delay(delay), m_last_time(-delay - 1)
+{
+	enforce(pit >= 0);
+	enforce(delay >= 0);
+
+	if(auto state = snapshot.get())
+		enforce((size_t)pit < state->pit().size());
+
+	Log::info("Agent: active as player %d, delay: %d", pit, delay);
+}
+
+void Agent::set_delay(const int delay)
+{
+	enforce(delay >= 0);
+
+	if(delay != m_delay)
+		Log::info("Agent: player %d, delay: %d", m_pit, delay);
+
+	m_delay = delay;
+}
+
+void Agent::set_input_delay(const int input_delay)
+{
+	enforce(input_delay >= 0);
+	m_input_delay = input_delay;
+}
+
 std::vector<PlayerInput> Agent::move()
 {
+	// base all decisions in this move on the same snapshot
+	if(m_snapshot) {
+		m_hold = m_snapshot->get();
+		m_state = m_hold.get();
+
+		if(!m_state)
+			return {}; // no game to play
+	}
+
 	if(m_state->game_time() <= m_last_time + m_delay)
 		return {};
 
 	const Pit& pit = *m_state->pit()[m_pit];
-	const int time = m_state->game_time() + 1; // produce inputs for this time
+	const int time = m_state->game_time() + 1 + m_input_delay; // produce inputs for this time
 	std::vector<PlayerInput> inputs;
 
 	// control raise
@@ -310,7 +347,7 @@ std::vector<PlayerInput> Agent::move()
 
 	// set up input delay
 	if(!inputs.empty()) {
-		m_last_time = m_state->game_time();
+		m_last_time = time - 1;
 	}
 
 	return inputs;
@@ -10,6 +10,7 @@
 // forward declarations
 class Pit;
 class GameState;
+class SnapshotHandle;
 
 /**
  * A model of intent for the agent to perform a series of actions towards
@@ -227,14 +228,40 @@ public:
 	 */
 	explicit Agent(const GameState& state, int pit, int delay);
 
+	/**
+	 * Construct the agent to play on the published snapshots of a game.
+	 * Every move() is based on the latest snapshot at the time, so that
+	 * the agent can run outside the simulation.
+	 *
+	 * @param snapshot source of game states to base decisions on
+	 * @param pit number of the pit under control of the agent
+	 * @param delay to weaken the agent, it will only be permitted to move every N ticks
+	 */
+	explicit Agent(const SnapshotHandle& snapshot, int pit, int delay);
+
+	/**
+	 * Change the number of ticks that the agent waits between moves.
+	 */
+	void set_delay(int delay);
+
+	/**
+	 * Change the number of ticks by which the agent schedules its inputs
+	 * after the state that it bases them on, see @c IGame::input_delay.
+	 * The agent waits for its inputs to take effect before it moves again.
+	 */
+	void set_input_delay(int input_delay);
+
 	std::vector<PlayerInput> move();
 
 private:
 
+	const SnapshotHandle* m_snapshot; //!< source of game states, if not fixed
+	std::shared_ptr<const GameState> m_hold; //!< keeps the current snapshot alive
 	const GameState* m_state; //!< game state object to base decisions on
 	int m_pit; //!< pit under control of the agent
 	int m_delay; //!< enforced wait time between moves
-	long m_last_time; //!< game state time of last generated move
+	int m_input_delay = 0; //!< ticks between the decision and the effect of a move
+	long m_last_time; //!< game state time before the last generated move takes effect
 	Plan m_plan; //!< current tactical aim of the agent's movement
 
 	/**
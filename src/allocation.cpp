@@ -0,0 +1,115 @@
+#include "allocation.hpp"
+#include <atomic>
+#include <cassert>
+#include <mutex>
+
+namespace
+{
+
+std::atomic<long> phase_allocations[ALLOC_PHASES];
+std::atomic<long> allocated_bytes{0};
+std::atomic<long> peak_bytes{0};
+std::atomic<bool> hooks_active{false};
+
+thread_local AllocPhase current_phase = AllocPhase::OTHER;
+
+std::mutex tick_mutex;
+AllocationCounts tick_begin; //!< counts at the end of the previous tick
+AllocationCounts last_tick; //!< allocations in the latest complete tick
+
+}
+
+const char* alloc_phase_name(AllocPhase phase) noexcept
+{
+	switch(phase) {
+		case AllocPhase::OTHER: return "OTHER";
+		case AllocPhase::PIT_UPDATE: return "PIT";
+		case AllocPhase::DIRECTOR_UPDATE: return "DIRECTOR";
+		case AllocPhase::ROLLBACK: return "ROLLBACK";
+		case AllocPhase::CHECKPOINT: return "CHECKPOINT";
+		case AllocPhase::SNAPSHOT: return "SNAPSHOT";
+		case AllocPhase::NETWORK_POLL: return "NETWORK";
+		case AllocPhase::DRAW: return "DRAW";
+		default: assert(false); return "";
+	}
+}
+
+long AllocationCounts::total() const noexcept
+{
+	long sum = 0;
+	for(long count : allocations)
+		sum += count;
+	return sum;
+}
+
+AllocationCounts AllocationCounts::since(const AllocationCounts& earlier) const noexcept
+{
+	AllocationCounts result = *this;
+	for(size_t i = 0; i < ALLOC_PHASES; i++)
+		result.allocations[i] -= earlier.allocations[i];
+	return result;
+}
+
+bool allocation_counting() noexcept
+{
+	return hooks_active.load(std::memory_order_relaxed);
+}
+
+AllocationCounts allocation_counts() noexcept
+{
+	AllocationCounts counts;
+	for(size_t i = 0; i < ALLOC_PHASES; i++)
+		counts.allocations[i] = phase_allocations[i].load(std::memory_order_relaxed);
+	counts.bytes = allocated_bytes.load(std::memory_order_relaxed);
+	counts.peak_bytes = peak_bytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+void reset_allocation_peak() noexcept
+{
+	peak_bytes.store(allocated_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void allocation_tick() noexcept
+{
+	const AllocationCounts counts = allocation_counts();
+	std::lock_guard<std::mutex> lock{tick_mutex};
+	last_tick = counts.since(tick_begin);
+	tick_begin = counts;
+}
+
+AllocationCounts tick_allocations() noexcept
+{
+	std::lock_guard<std::mutex> lock{tick_mutex};
+	return last_tick;
+}
+
+void note_allocation(size_t size) noexcept
+{
+	hooks_active.store(true, std::memory_order_relaxed);
+	phase_allocations[static_cast<size_t>(current_phase)].fetch_add(1, std::memory_order_relaxed);
+
+	const long bytes = allocated_bytes.fetch_add(static_cast<long>(size), std::memory_order_relaxed) + static_cast<long>(size);
+	long peak = peak_bytes.load(std::memory_order_relaxed);
+	while(bytes > peak && !peak_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {}
+}
+
+void note_deallocation(size_t size) noexcept
+{
+	allocated_bytes.fetch_sub(static_cast<long>(size), std::memory_order_relaxed);
+}
+
+#if defined(SHITBRIX_COUNT_ALLOCATIONS)
+
+AllocationScope::AllocationScope(AllocPhase phase) noexcept
+	: m_previous(current_phase)
+{
+	current_phase = phase;
+}
+
+AllocationScope::~AllocationScope() noexcept
+{
+	current_phase = m_previous;
+}
+
+#endif
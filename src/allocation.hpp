@@ -0,0 +1,136 @@
+/**
+ * Counting of heap allocations, attributed to the phases of the game loop.
+ *
+ * The counts come from replacements of the global operator new and delete
+ * in allocation_hooks.cpp. Only programs which link these hooks count their
+ * allocations: the benchmarks always, all other programs in the
+ * instrumentation build (CMake option SHITBRIX_COUNT_ALLOCATIONS).
+ * Otherwise, all counts stay zero.
+ *
+ * The instrumentation build also defines SHITBRIX_COUNT_ALLOCATIONS for the
+ * code, which activates the phase scopes. Without it, the scopes compile to
+ * nothing and all allocations count towards @c AllocPhase::OTHER.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Parts of the program to which allocations are attributed.
+ */
+enum class AllocPhase
+{
+	OTHER,           //!< anything outside the other phases
+	PIT_UPDATE,      //!< @c Pit::update
+	DIRECTOR_UPDATE, //!< @c BlockDirector::update and input application
+	ROLLBACK,        //!< restoring the state from a checkpoint in @c IGame::synchronurse
+	CHECKPOINT,      //!< copying the state into journal checkpoints
+	SNAPSHOT,        //!< publishing the state to observers
+	NETWORK_POLL,    //!< receiving and handling network messages
+	DRAW,            //!< drawing the screen
+	COUNT            //!< number of phases
+};
+
+constexpr size_t ALLOC_PHASES = static_cast<size_t>(AllocPhase::COUNT);
+
+/**
+ * Return a short upper-case name for the phase, e.g. for the debug overlay.
+ */
+const char* alloc_phase_name(AllocPhase phase) noexcept;
+
+/**
+ * Allocation statistics of the whole program.
+ */
+struct AllocationCounts
+{
+	std::array<long, ALLOC_PHASES> allocations{}; //!< number of allocations per phase
+	long bytes = 0; //!< currently allocated bytes
+	long peak_bytes = 0; //!< highest allocated bytes since the last @c reset_allocation_peak
+
+	long total() const noexcept;
+
+	/**
+	 * Return the number of allocations by phase since the @c earlier counts.
+	 * The byte values remain the current ones.
+	 */
+	AllocationCounts since(const AllocationCounts& earlier) const noexcept;
+};
+
+/**
+ * Return true if the allocation hooks are linked into the program.
+ */
+bool allocation_counting() noexcept;
+
+/**
+ * Return the current allocation statistics.
+ */
+AllocationCounts allocation_counts() noexcept;
+
+/**
+ * Restart tracking the peak allocated bytes from the current value.
+ */
+void reset_allocation_peak() noexcept;
+
+/**
+ * Mark the end of one game tick.
+ * Afterwards, @c tick_allocations returns the allocations since the last mark.
+ */
+void allocation_tick() noexcept;
+
+/**
+ * Return the allocations by phase in the latest complete tick.
+ */
+AllocationCounts tick_allocations() noexcept;
+
+/**
+ * Record an allocation of the given size in the current phase.
+ * Intended for use by the allocation hooks.
+ */
+void note_allocation(size_t size) noexcept;
+
+/**
+ * Record the release of an allocation of the given size.
+ * Intended for use by the allocation hooks.
+ */
+void note_deallocation(size_t size) noexcept;
+
+#if defined(SHITBRIX_COUNT_ALLOCATIONS)
+
+/**
+ * Attributes all allocations in the current thread to the given phase,
+ * for as long as the scope object lives. Scopes can be nested.
+ */
+class AllocationScope
+{
+
+public:
+
+	explicit AllocationScope(AllocPhase phase) noexcept;
+	~AllocationScope() noexcept;
+	AllocationScope(const AllocationScope& ) = delete;
+	AllocationScope& operator=(const AllocationScope& ) = delete;
+
+private:
+
+	AllocPhase m_previous; //!< phase to restore at the end of the scope
+
+};
+
+#else
+
+/**
+ * Outside of the instrumentation build, scopes have no effect.
+ */
+class AllocationScope
+{
+
+public:
+
+	explicit AllocationScope(AllocPhase ) noexcept {}
+	AllocationScope(const AllocationScope& ) = delete;
+	AllocationScope& operator=(const AllocationScope& ) = delete;
+
+};
+
+#endif
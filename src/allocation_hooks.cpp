@@ -0,0 +1,48 @@
+/**
+ * Replacements of the global allocation functions, which report every
+ * allocation to the counters in allocation.hpp.
+ *
+ * This file is not part of any library. Only programs which count their
+ * allocations compile it in, see allocation.hpp.
+ * Every block carries a header with its size, so that the counters can
+ * track the allocated bytes.
+ */
+
+#include "allocation.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void* counted_alloc(size_t size)
+{
+	void* block = std::malloc(size + HEADER_SIZE);
+	if(nullptr == block)
+		throw std::bad_alloc{};
+
+	*static_cast<size_t*>(block) = size;
+	note_allocation(size);
+	return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void counted_free(void* ptr) noexcept
+{
+	if(nullptr == ptr)
+		return;
+
+	void* block = static_cast<char*>(ptr) - HEADER_SIZE;
+	note_deallocation(*static_cast<size_t*>(block));
+	std::free(block);
+}
+
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, size_t ) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, size_t ) noexcept { counted_free(ptr); }
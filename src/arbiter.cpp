@@ -40,13 +40,17 @@ namespace
 
 /**
  * Return the appropriate @c SpawnGarbageInputs that follow a successful block match.
+ * The result list lives in the given memory resource.
  */
-std::vector<Input> inputs_from_match(evt::Match match, const GameState& state, IColorSupplier& color_supplier);
+std::pmr::vector<Input> inputs_from_match(evt::Match match, const GameState& state, IColorSupplier& color_supplier,
+                                          std::pmr::memory_resource* memory);
 
 /**
  * Return the appropriate @c SpawnGarbageInput that follows a successful chain match.
+ * The result list lives in the given memory resource.
  */
-std::vector<Input> input_from_chain(evt::Chain chain, const GameState& state, IColorSupplier& color_supplier);
+std::pmr::vector<Input> input_from_chain(evt::Chain chain, const GameState& state, IColorSupplier& color_supplier,
+                                         std::pmr::memory_resource* memory);
 
 /**
  * Return the appropriate @c SpawnBlockInput for a pit in need of a refill.
@@ -71,16 +75,20 @@ LocalArbiter::LocalArbiter(GameState& state, Journal& journal,
 
 void LocalArbiter::fire(evt::Match match)
 {
-	for(Input input : inputs_from_match(match, *m_state, *m_color_supplier)) {
+	for(Input input : inputs_from_match(match, *m_state, *m_color_supplier, m_scratch.resource())) {
 		m_journal->add_input(std::move(input));
 	}
+
+	m_scratch.release();
 }
 
 void LocalArbiter::fire(evt::Chain chain)
 {
-	for(Input input : input_from_chain(chain, *m_state, *m_color_supplier)) {
+	for(Input input : input_from_chain(chain, *m_state, *m_color_supplier, m_scratch.resource())) {
 		m_journal->add_input(std::move(input));
 	}
+
+	m_scratch.release();
 }
 
 void LocalArbiter::fire(evt::Starve starve)
@@ -97,18 +105,22 @@ ServerArbiter::ServerArbiter(ServerProtocol& server_protocol, GameState& state,
 
 void ServerArbiter::fire(evt::Match match)
 {
-	for(Input input : inputs_from_match(match, *m_state, *m_color_supplier)) {
+	for(Input input : inputs_from_match(match, *m_state, *m_color_supplier, m_scratch.resource())) {
 		m_journal->add_input(input);
 		m_server_protocol->input(input);
 	}
+
+	m_scratch.release();
 }
 
 void ServerArbiter::fire(evt::Chain chain)
 {
-	for(Input input : input_from_chain(chain, *m_state, *m_color_supplier)) {
+	for(Input input : input_from_chain(chain, *m_state, *m_color_supplier, m_scratch.resource())) {
 		m_journal->add_input(input);
 		m_server_protocol->input(input);
 	}
+
+	m_scratch.release();
 }
 
 void ServerArbiter::fire(evt::Starve starve)
@@ -122,12 +134,13 @@ void ServerArbiter::fire(evt::Starve starve)
 namespace
 {
 
-std::vector<Input> inputs_from_match(evt::Match match, const GameState& state, IColorSupplier& color_supplier)
+std::pmr::vector<Input> inputs_from_match(evt::Match match, const GameState& state, IColorSupplier& color_supplier,
+                                          std::pmr::memory_resource* memory)
 {
 	int victim = state.opponent(match.trivia.player);
 	int input_time = match.trivia.game_time + 1; // reaction to event
 
-	std::vector<Input> inputs;
+	std::pmr::vector<Input> inputs(memory);
 
 	if(match.combo >= 3) {
 		int counter = match.combo - 3; // number of small blocks to drop
@@ -149,17 +162,21 @@ std::vector<Input> inputs_from_match(evt::Match match, const GameState& state, I
 	return inputs;
 }
 
-std::vector<Input> input_from_chain(evt::Chain chain, const GameState& state, IColorSupplier& color_supplier)
+std::pmr::vector<Input> input_from_chain(evt::Chain chain, const GameState& state, IColorSupplier& color_supplier,
+                                         std::pmr::memory_resource* memory)
 {
+	std::pmr::vector<Input> inputs(memory);
+
 	if(chain.counter <= 0)
-		return {}; // no chain - no garbage
+		return inputs; // no chain - no garbage
 
 	int victim = state.opponent(chain.trivia.player);
 	int input_time = chain.trivia.game_time + 1; // reaction to event
 
 	// Even though the interface allows us to throw any number of garbage bricks,
 	// the current gameplay rules prescribe just one, no matter how big.
-	return {input_garbage(input_time, victim, PIT_COLS, chain.counter, false, state, color_supplier)};
+	inputs.push_back(input_garbage(input_time, victim, PIT_COLS, chain.counter, false, state, color_supplier));
+	return inputs;
 }
 
 Input input_from_starve(evt::Starve starve, const GameState& state, IColorSupplier& color_supplier)
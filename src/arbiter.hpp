@@ -1,6 +1,7 @@
 #pragma once
 
 #include "event.hpp"
+#include "scratch.hpp"
 
 class Journal;
 class GameState;
@@ -125,6 +126,7 @@ private:
 	GameState* m_state; //!< active game state
 	Journal* m_journal; //!< active game record
 	std::unique_ptr<IColorSupplier> m_color_supplier; //!< rng component
+	ScratchArena m_scratch{ARBITER_SCRATCH_SIZE}; //!< temporary memory for one decision
 
 };
 
@@ -151,5 +153,6 @@ private:
 	GameState* m_state; //!< active game state
 	Journal* m_journal; //!< active game record
 	std::unique_ptr<IColorSupplier> m_color_supplier; //!< rng component
+	ScratchArena m_scratch{ARBITER_SCRATCH_SIZE}; //!< temporary memory for one decision
 
 };
@@ -1,40 +1,43 @@
 #include "configuration.hpp"
 #include "context.hpp"
 #include "globals.hpp"
-#include "sdl_helper.hpp"
-#include "asset.hpp"
-#include "audio.hpp"
 #include "error.hpp"
 #include <fstream>
-#include <regex>
+#include <iterator>
+#include <charconv>
 #include <functional>
+#include <array>
+#include <algorithm>
 #include <map>
-#include <SDL.h>
+#include <cctype>
 
 namespace
 {
 
 /**
- * Return the corresponding @c LaunchMode for the string representation.
- * @throw ConfigException if the string is not recognized.
+ * Schema entry for one configuration key.
+ * It converts the value between its string representation and the typed
+ * member of the @c Configuration and validates it on the way in.
  */
-LaunchMode parse_launch_mode(std::string value);
-
-/**
- * If the string value contains data, convert it to an integer and return it.
- * If the string value is empty, return an empty optional.
- */
-std::optional<int> to_opt_int(const std::string& value);
+struct ConfigField
+{
+	bool runtime; //!< the value may change while the program runs
+	std::function<void(Configuration&, std::string_view)> parse; //!< validate and set the value
+	std::function<std::string(const Configuration&)> format; //!< get the string representation of the value
+};
 
 /**
- * Type of a function that sets one configuration variable to the given value.
+ * Lookup table of all configuration keys.
  */
-using ConfigSetter = std::function<void(Configuration&, std::string)>;
+extern const std::map<std::string, ConfigField, std::less<>> config_schema;
 
 /**
- * Lookup table of setter functions by configuration key name.
+ * Split a line of the form "key = value" into key and value.
+ * The key consists of word characters and dots. The value extends to the end
+ * of the line, without surrounding whitespace.
+ * If the line does not have this form, return an empty key.
  */
-extern const std::map<std::string, ConfigSetter> config_setter;
+std::pair<std::string_view, std::string_view> split_assignment(std::string_view line) noexcept;
 
 }
 
@@ -50,24 +53,41 @@ Configuration::Configuration()
   replay_path{},
   log_path{"logfile.txt"},
   server_url{},
-  port{DEFAULT_PORT}
+  port{DEFAULT_PORT},
+  netsim{},
+  log_level{Log::Level::TRACE},
+  ai_delay{},
+  polls_per_tick{1},
+  net_batching{false}
 {
 }
 
 void Configuration::read_from_file(std::filesystem::path path)
 {
-	std::ifstream stream{path};
-	std::string line;
-	
-	while(std::getline(stream, line)) {
-		const std::regex line_ex{R"(^\s*([\w\.]+)[\s=]+(.*)$)"};
-		std::cmatch result;
+	std::ifstream stream{path, std::ios::binary};
+	if(!stream)
+		throwx<ConfigException>("Cannot read configuration file %s", path.u8string().c_str());
+
+	// read the whole file at once and parse it in place
+	const std::string content{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+	int line_number = 0;
+
+	for(size_t begin = 0; begin < content.size();) {
+		const size_t end = std::min(content.find('\n', begin), content.size());
+		const std::string_view line{content.data() + begin, end - begin};
+		begin = end + 1;
+		line_number++;
 
-		if(std::regex_match(line.c_str(), result, line_ex)) {
-			const std::string key{result[1]};
-			const std::string value{result[2]};
+		const auto [key, value] = split_assignment(line);
+		if(key.empty())
+			continue;
+
+		try {
 			parse(key, value);
 		}
+		catch(const ConfigException& ex) {
+			throwx<ConfigException>("%s(%d): %s", path.u8string().c_str(), line_number, ex.what());
+		}
 	}
 
 	normalize();
@@ -76,22 +96,18 @@ void Configuration::read_from_file(std::filesystem::path path)
 void Configuration::read_from_args(int argc, const char* argv[])
 {
 	for(int i = 1; i < argc; i++) {
-		const std::regex assign_ex{R"(^--\s*(\w+)[\s=]+(.*)$)"};
-		std::cmatch result;
+		const std::string_view arg{argv[i]};
+
+		if("--" != arg.substr(0, 2)) {
+			throwx<ConfigException>("Unrecognized argument: %s", argv[i]);
+		}
 
-		if(std::regex_match(argv[i], result, assign_ex)) {
-			const std::string key{result[1]};
-			const std::string value{result[2]};
+		if(const auto [key, value] = split_assignment(arg.substr(2)); !key.empty()) {
 			parse(key, value);
 		}
 		else if(i+1 < argc) {
-			if("--" == std::string(argv[i]).substr(0, 2)) {
-				parse(argv[i] + 2, argv[i + 1]);
-				i++;
-			}
-			else {
-				throwx<ConfigException>("Unrecognized argument: %s", argv[i]);
-			}
+			parse(arg.substr(2), argv[i + 1]);
+			i++;
 		}
 		else {
 			throwx<ConfigException>("Missing parameter for %s", argv[i]);
@@ -101,14 +117,47 @@ void Configuration::read_from_args(int argc, const char* argv[])
 	normalize();
 }
 
-void Configuration::parse(std::string key, std::string value)
+void Configuration::apply_runtime() const
 {
-	auto found = config_setter.find(key);
+	Log::set_level(log_level);
 
-	if(config_setter.end() == found)
-		throwx<ConfigException>("Unknown configuration key: %s", key.c_str());
+	RuntimeSettings& settings = runtime_settings();
+	settings.ai_delay.store(ai_delay.value_or(-1));
+	settings.polls_per_tick.store(polls_per_tick);
+	settings.net_batching.store(net_batching);
+}
 
-	found->second(*this, value);
+std::vector<std::string> Configuration::diff(const Configuration& other) const
+{
+	std::vector<std::string> keys;
+
+	for(const auto& [key, field] : config_schema) {
+		if(field.format(*this) != field.format(other))
+			keys.push_back(key);
+	}
+
+	return keys;
+}
+
+bool Configuration::is_runtime_key(const std::string& key)
+{
+	const auto found = config_schema.find(key);
+	return config_schema.end() != found && found->second.runtime;
+}
+
+void Configuration::parse(std::string_view key, std::string_view value)
+{
+	const auto found = config_schema.find(key);
+
+	if(config_schema.end() == found)
+		throwx<ConfigException>("Unknown configuration key: %s", std::string{key}.c_str());
+
+	try {
+		found->second.parse(*this, value);
+	}
+	catch(const ConfigException& ex) {
+		throwx<ConfigException>("%s: %s", found->first.c_str(), ex.what());
+	}
 }
 
 void Configuration::normalize()
@@ -122,69 +171,250 @@ void Configuration::normalize()
 
 	if(rules.cursor_delay < 0)
 		rules.cursor_delay = 0;
+
+	if(rules.input_delay < INPUT_DELAY_AUTO || rules.input_delay > MAX_INPUT_DELAY)
+		rules.input_delay = 0;
+}
+
+
+RuntimeSettings& runtime_settings() noexcept
+{
+	static RuntimeSettings settings;
+	return settings;
 }
 
 
-void configure_context(const Configuration& configuration)
+ConfigWatcher::ConfigWatcher(std::filesystem::path path, std::vector<std::string> args,
+	std::chrono::milliseconds check_interval)
+	: m_path(std::move(path)),
+	m_args(std::move(args)),
+	m_check_interval(check_interval),
+	m_write_time(std::filesystem::last_write_time(m_path)),
+	m_current(load()),
+	m_next_check(std::chrono::steady_clock::now() + check_interval)
 {
-	the_context.configuration.reset(new Configuration(configuration));
+}
+
+bool ConfigWatcher::poll()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if(now < m_next_check)
+		return false;
+
+	m_next_check = now + m_check_interval;
+
+	std::error_code error;
+	const auto write_time = std::filesystem::last_write_time(m_path, error);
+	if(error || write_time == m_write_time)
+		return false;
+
+	m_write_time = write_time;
 
-	const bool is_server_only = LaunchMode::SERVER == the_context.configuration->launch_mode;
-	Uint32 sdl_flags = is_server_only ? SDL_INIT_TIMER | SDL_INIT_EVENTS
-	                                  : SDL_INIT_EVERYTHING;
+	try {
+		Configuration loaded = load();
 
-	the_context.sdl.reset(new Sdl(sdl_flags));
-	the_context.log = create_file_log(the_context.configuration->log_path);
+		for(const std::string& key : m_current.diff(loaded)) {
+			if(Configuration::is_runtime_key(key))
+				Log::info("Configuration: %s changed.", key.c_str());
+			else
+				Log::info("Configuration: %s changed, but takes effect only after a restart.", key.c_str());
+		}
 
-	if(is_server_only) {
-		the_context.assets.reset(new NoAssets);
-		the_context.audio.reset(new NoAudio);
+		loaded.apply_runtime();
+		m_current = std::move(loaded);
+		return true;
 	}
-	else {
-		the_context.assets.reset(new FileAssets(*the_context.sdl));
-		the_context.audio.reset(new SdlAudio(the_context.sdl->audio()));
+	catch(const std::exception& ex) {
+		Log::error("Configuration reload failed, keeping the current settings: %s", ex.what());
+		return false;
 	}
 }
 
+Configuration ConfigWatcher::load() const
+{
+	std::vector<const char*> argv{""}; // program name
+	for(const std::string& arg : m_args)
+		argv.push_back(arg.c_str());
+
+	Configuration configuration;
+	configuration.read_from_file(m_path);
+	configuration.read_from_args(static_cast<int>(argv.size()), argv.data());
+	return configuration;
+}
+
 
 namespace
 {
 
-const char* launch_mode_string[] =
-{ "menu", "local", "client", "server", "with-server"};
+std::pair<std::string_view, std::string_view> split_assignment(std::string_view line) noexcept
+{
+	const auto is_space = [](char c) { return 0 != std::isspace(static_cast<unsigned char>(c)); };
+	const auto is_key = [](char c) { return 0 != std::isalnum(static_cast<unsigned char>(c)) || '_' == c || '.' == c; };
+
+	size_t pos = 0;
+	while(pos < line.size() && is_space(line[pos]))
+		pos++;
+
+	const size_t key_begin = pos;
+	while(pos < line.size() && is_key(line[pos]))
+		pos++;
+
+	const size_t key_end = pos;
+	while(pos < line.size() && (is_space(line[pos]) || '=' == line[pos]))
+		pos++;
+
+	if(key_begin == key_end || key_end == pos)
+		return {};
+
+	std::string_view value = line.substr(pos);
+	while(!value.empty() && is_space(value.back()))
+		value.remove_suffix(1);
+
+	return {line.substr(key_begin, key_end - key_begin), value};
+}
+
+/**
+ * Integer values in the range from min to max (inclusive).
+ */
+struct IntType
+{
+	int min;
+	int max;
+
+	int parse(std::string_view value) const
+	{
+		const char* const end = value.data() + value.size();
+		int result = 0;
+		const auto [ptr, error] = std::from_chars(value.data(), end, result);
+
+		if(std::errc{} != error || end != ptr)
+			throwx<ConfigException>("Not an integer: \"%s\"", std::string{value}.c_str());
 
-LaunchMode parse_launch_mode(std::string value)
+		if(result < min || result > max)
+			throwx<ConfigException>("Value %d is out of range [%d, %d]", result, min, max);
+
+		return result;
+	}
+
+	std::string format(int value) const { return std::to_string(value); }
+};
+
+/**
+ * Integer values which may be absent. An empty string means no value.
+ */
+struct OptIntType
+{
+	IntType base;
+
+	std::optional<int> parse(std::string_view value) const
+	{
+		if(value.empty())
+			return {};
+		else
+			return base.parse(value);
+	}
+
+	std::string format(std::optional<int> value) const { return value ? base.format(*value) : ""; }
+};
+
+/**
+ * Boolean values, "true" or "false".
+ */
+struct BoolType
 {
-	const auto mode_found = std::find(launch_mode_string, std::end(launch_mode_string), value);
-	const size_t mode_index = std::distance(launch_mode_string, mode_found);
+	bool parse(std::string_view value) const
+	{
+		if("true" != value && "false" != value)
+			throwx<ConfigException>("Not a boolean (true/false): \"%s\"", std::string{value}.c_str());
+
+		return "true" == value;
+	}
 
-	if(std::size(launch_mode_string) <= mode_index)
-		throwx<ConfigException>("Invalid launch mode: \"%s\"", value.c_str());
+	std::string format(bool value) const { return value ? "true" : "false"; }
+};
 
-	return static_cast<LaunchMode>(mode_index);
+/**
+ * Free-form text values.
+ */
+struct StringType
+{
+	std::string parse(std::string_view value) const { return std::string{value}; }
+	std::string format(const std::optional<std::string>& value) const { return value.value_or(""); }
+};
+
+/**
+ * File system path values.
+ */
+struct PathType
+{
+	std::filesystem::path parse(std::string_view value) const { return std::filesystem::path{value}; }
+	std::string format(const std::filesystem::path& value) const { return value.u8string(); }
+	std::string format(const std::optional<std::filesystem::path>& value) const { return value ? value->u8string() : ""; }
+};
+
+/**
+ * Enumeration values, which are represented by the names in the order of the enumerators.
+ */
+template<typename Enum, size_t N>
+struct EnumType
+{
+	const std::array<const char*, N>& names;
+
+	Enum parse(std::string_view value) const
+	{
+		const auto found = std::find(names.begin(), names.end(), value);
+		if(names.end() == found)
+			throwx<ConfigException>("Invalid value: \"%s\"", std::string{value}.c_str());
+
+		return static_cast<Enum>(std::distance(names.begin(), found));
+	}
+
+	std::string format(Enum value) const { return names.at(static_cast<size_t>(value)); }
+};
+
+const std::array<const char*, 5> launch_mode_names{"menu", "local", "client", "server", "with-server"};
+const std::array<const char*, 3> log_level_names{"trace", "info", "error"};
+
+/**
+ * Return the schema entry for the member which the @c access function selects.
+ * @c access must return a reference to the member for const and non-const configurations.
+ */
+template<typename Type, typename Access>
+ConfigField field(Type type, Access access, bool runtime = false)
+{
+	return ConfigField{
+		runtime,
+		[type, access](Configuration& c, std::string_view value) { access(c) = type.parse(value); },
+		[type, access](const Configuration& c) { return type.format(access(c)); }
+	};
 }
 
-std::optional<int> to_opt_int(const std::string& value)
+const bool RUNTIME = true; //!< marks settings which may change while the program runs
+
+const std::map<std::string, ConfigField, std::less<>> config_schema
 {
-	if(value.empty())
-		return {};
-	else
-		return std::stoi(value);
-}
-
-const std::map<std::string, ConfigSetter> config_setter
-{
-	{"player_number",      [](Configuration& c, std::string value) { c.player_number   = to_opt_int(value); }},
-	{"launch_mode",        [](Configuration& c, std::string value) { c.launch_mode     = parse_launch_mode(value); }},
-	{"joystick_number",    [](Configuration& c, std::string value) { c.joystick_number = to_opt_int(value); }},
-	{"ai_player",          [](Configuration& c, std::string value) { c.ai_player       = to_opt_int(value); }},
-	{"ai_level",           [](Configuration& c, std::string value) { c.ai_level = std::stoi(value); }},
-	{"rules.cursor_delay", [](Configuration& c, std::string value) { c.rules.cursor_delay = std::stoi(value); }},
-	{"autorecord",         [](Configuration& c, std::string value) { c.autorecord      = "true" == value; }},
-	{"replay_path",        [](Configuration& c, std::string value) { c.replay_path     = std::filesystem::path{value}; }},
-	{"log_path",           [](Configuration& c, std::string value) { c.log_path        = std::filesystem::path{value}; }},
-	{"server_url",         [](Configuration& c, std::string value) { c.server_url      = value; }},
-	{"port",               [](Configuration& c, std::string value) { c.port            = std::stoi(value); }},
+	{"player_number",      field(OptIntType{{0, 1}}, [](auto& c) -> auto& { return c.player_number; })},
+	{"launch_mode",        field(EnumType<LaunchMode, 5>{launch_mode_names}, [](auto& c) -> auto& { return c.launch_mode; })},
+	{"joystick_number",    field(OptIntType{{0, 255}}, [](auto& c) -> auto& { return c.joystick_number; })},
+	{"ai_player",          field(OptIntType{{0, 1}}, [](auto& c) -> auto& { return c.ai_player; })},
+	{"ai_level",           field(IntType{0, 2}, [](auto& c) -> auto& { return c.ai_level; })},
+	{"rules.cursor_delay", field(IntType{0, 60 * TPS}, [](auto& c) -> auto& { return c.rules.cursor_delay; })},
+	{"rules.input_delay",  field(IntType{INPUT_DELAY_AUTO, MAX_INPUT_DELAY}, [](auto& c) -> auto& { return c.rules.input_delay; })},
+	{"autorecord",         field(BoolType{}, [](auto& c) -> auto& { return c.autorecord; })},
+	{"replay_path",        field(PathType{}, [](auto& c) -> auto& { return c.replay_path; })},
+	{"log_path",           field(PathType{}, [](auto& c) -> auto& { return c.log_path; })},
+	{"server_url",         field(StringType{}, [](auto& c) -> auto& { return c.server_url; })},
+	{"port",               field(IntType{1, 65535}, [](auto& c) -> auto& { return c.port; })},
+	{"netsim.latency",     field(IntType{0, 10000}, [](auto& c) -> auto& { return c.netsim.latency; })},
+	{"netsim.jitter",      field(IntType{0, 10000}, [](auto& c) -> auto& { return c.netsim.jitter; })},
+	{"netsim.loss",        field(IntType{0, 99}, [](auto& c) -> auto& { return c.netsim.loss; })},
+	{"netsim.duplication", field(IntType{0, 100}, [](auto& c) -> auto& { return c.netsim.duplication; })},
+	{"netsim.reordering",  field(IntType{0, 100}, [](auto& c) -> auto& { return c.netsim.reordering; })},
+	{"netsim.reliable",    field(BoolType{}, [](auto& c) -> auto& { return c.netsim.reliable; })},
+	{"log_level",          field(EnumType<Log::Level, 3>{log_level_names}, [](auto& c) -> auto& { return c.log_level; }, RUNTIME)},
+	{"ai_delay",           field(OptIntType{{0, 10 * TPS}}, [](auto& c) -> auto& { return c.ai_delay; }, RUNTIME)},
+	{"polls_per_tick",     field(IntType{1, 100}, [](auto& c) -> auto& { return c.polls_per_tick; }, RUNTIME)},
+	{"net_batching",       field(BoolType{}, [](auto& c) -> auto& { return c.net_batching; }, RUNTIME)},
 };
 
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <optional>
 #include <filesystem>
+#include <atomic>
+#include <chrono>
 #include "globals.hpp"
+#include "error.hpp"
 
 /**
  * Initial mode (start screen) of the application.
@@ -21,6 +26,7 @@ enum class LaunchMode
  * A collection of values that govern application behavior.
  * Configuration values can be read from a configuration
  * file or from command-line options.
+ * Every key has a fixed type and range, which both sources validate.
  * Configuration values come in an ordered hierarchy, where values
  * from higher configuration sources override lower ones.
  * From low to high, the sources are in this order:
@@ -112,11 +118,45 @@ public:
 	 */
 	int port;
 
+	/**
+	 * Simulated adverse network conditions on the connection to the server,
+	 * for testing. By default, the network is left as it is.
+	 */
+	NetConditions netsim;
+
+	// The following settings take effect at run-time, see @c ConfigWatcher.
+
+	/**
+	 * Least important level of messages which are written to the log.
+	 * By default, the log contains all messages, down to trace level.
+	 */
+	Log::Level log_level;
+
+	/**
+	 * Number of ticks that the planning agent waits after every move.
+	 * If set, this overrides the delay which derives from the ai_level.
+	 */
+	std::optional<int> ai_delay;
+
+	/**
+	 * Number of times per tick that the server loop handles network messages.
+	 * More frequent polling reduces the latency of inputs at the cost of CPU time.
+	 */
+	int polls_per_tick;
+
+	/**
+	 * When true, network channels collect outgoing messages and send them
+	 * together at the next poll instead of flushing every message at once.
+	 * This saves packets at the cost of latency.
+	 */
+	bool net_batching;
+
 	/**
 	 * Read configuration values from the specified file.
 	 * The syntax is "key = value" on every line, where key is the name of one of
 	 * the member variables in this @c Configuration.
 	 * Ignore lines that start with non-word characters.
+	 * @throw ConfigException if a key is unknown or a value invalid
 	 */
 	void read_from_file(std::filesystem::path path);
 
@@ -124,16 +164,33 @@ public:
 	 * Read configuration values from command-line arguments.
 	 * The syntax is "--key=value" or "--key value" for every argument, where key
 	 * is the name of one of the member variables in this @c Configuration.
+	 * @throw ConfigException if a key is unknown or a value invalid
 	 */
 	void read_from_args(int argc, const char* argv[]);
 
+	/**
+	 * Make the run-time settings of this configuration effective for the
+	 * whole program, see @c runtime_settings.
+	 */
+	void apply_runtime() const;
+
+	/**
+	 * Return the keys of all values which differ between the configurations.
+	 */
+	std::vector<std::string> diff(const Configuration& other) const;
+
+	/**
+	 * Return true if the value of the given key can change at run-time.
+	 */
+	static bool is_runtime_key(const std::string& key);
+
 private:
 
 	/**
 	 * Set the configuration value with the given key name to the given value.
 	 * Convert the string representation of the value to the correct type.
 	 */
-	void parse(std::string key, std::string value);
+	void parse(std::string_view key, std::string_view value);
 
 	/**
 	 * Attempt to bring the configuration into a consistent state after loading it.
@@ -142,8 +199,67 @@ private:
 
 };
 
+/**
+ * The run-time settings currently in effect.
+ * Unlike the @c Configuration in the global context, they can change at any
+ * time, e.g. when the @c ConfigWatcher reloads the configuration file.
+ * Any thread may read them.
+ * The log level is not part of these settings; it belongs to the @c Log.
+ */
+struct RuntimeSettings
+{
+	std::atomic<int> ai_delay{-1}; //!< agent delay override, or -1 if unset
+	std::atomic<int> polls_per_tick{1};
+	std::atomic<bool> net_batching{false};
+};
+
+/**
+ * Return the run-time settings of the program.
+ */
+RuntimeSettings& runtime_settings() noexcept;
 
 /**
- * Instantiate the members of the global context based on the configuration.
+ * Watches the configuration file for changes and applies the run-time
+ * settings from it while the program runs, without a restart.
+ *
+ * Changes to other settings are ignored with a note in the log.
+ * If the file has become invalid, the watcher logs the error and keeps the
+ * settings in effect.
  */
-void configure_context(const Configuration& configuration);
+class ConfigWatcher
+{
+
+public:
+
+	static constexpr std::chrono::milliseconds CHECK_INTERVAL{1000};
+
+	/**
+	 * Construct the watcher on the configuration file.
+	 * The command-line arguments keep taking precedence over the file.
+	 * The file is examined at most once per @c check_interval, so that
+	 * @c poll is cheap enough to call on every tick.
+	 */
+	explicit ConfigWatcher(std::filesystem::path path, std::vector<std::string> args,
+		std::chrono::milliseconds check_interval = CHECK_INTERVAL);
+
+	/**
+	 * Check whether the file has changed and if so, apply its settings.
+	 * Return true if the file was reloaded.
+	 */
+	bool poll();
+
+private:
+
+	std::filesystem::path m_path;
+	std::vector<std::string> m_args; //!< command-line arguments to apply on top
+	std::chrono::milliseconds m_check_interval;
+	std::filesystem::file_time_type m_write_time; //!< modification time of the last load
+	Configuration m_current; //!< configuration as of the last successful load
+	std::chrono::steady_clock::time_point m_next_check; //!< do not look at the file before this time
+
+	/**
+	 * Read the file and the arguments into a fresh configuration.
+	 */
+	Configuration load() const;
+
+};
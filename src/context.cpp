@@ -9,3 +9,11 @@
 GlobalContext::~GlobalContext() = default;
 
 GlobalContext the_context;
+
+void configure_headless_context(const Configuration& configuration, std::unique_ptr<Logger> log)
+{
+	the_context.configuration.reset(new Configuration(configuration));
+	the_context.configuration->apply_runtime();
+	the_context.log = std::move(log);
+	the_context.audio.reset(new NoAudio);
+}
@@ -21,7 +21,7 @@ struct GlobalContext
 	~GlobalContext();
 
 	std::unique_ptr<Configuration> configuration; //!< application-wide configuration
-	std::unique_ptr<Sdl> sdl; //!< SDL library interface
+	std::shared_ptr<Sdl> sdl; //!< SDL library interface (shared to bind the deleter at setup, so that the headless server links without SDL)
 	std::unique_ptr<Logger> log; //!< logger
 	std::unique_ptr<Assets> assets; //!< game asset loader
 	std::unique_ptr<Audio> audio; //!< sound output interface
@@ -33,3 +33,11 @@ struct GlobalContext
  * contained interfaces point to implementations.
  */
 extern GlobalContext the_context;
+
+/**
+ * Set up the context for programs without a user interface, such as the
+ * dedicated server, tools and benchmarks.
+ * The context takes the configuration and the given log. It receives silent
+ * audio, while SDL and the assets stay uninitialized.
+ */
+void configure_headless_context(const Configuration& configuration, std::unique_ptr<Logger> log);
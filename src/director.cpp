@@ -7,6 +7,7 @@
 #include "logic.hpp"
 #include "arbiter.hpp"
 #include "replay.hpp"
+#include "allocation.hpp"
 #include "error.hpp"
 #include <cassert>
 
@@ -22,13 +23,21 @@ BlockDirector::BlockDirector()
 
 void BlockDirector::update()
 {
+	AllocationScope scope{AllocPhase::DIRECTOR_UPDATE};
+
 	for(int player = 0; player < m_state->pit().size(); player++)
 		update_single(player);
+
+	m_scratch.release();
 }
 
 void BlockDirector::apply_input(const Input& input)
 {
-	Log::trace("%s %s", __FUNCTION__, std::string(input).c_str());
+	AllocationScope scope{AllocPhase::DIRECTOR_UPDATE};
+
+	// Formatting the input allocates, so we only do it if the message is written.
+	if(Log::enabled(Log::Level::TRACE))
+		Log::trace("%s %s", __FUNCTION__, std::string(input).c_str());
 
 	input.visit([this](auto&& i) { apply_input(i); });
 }
@@ -50,8 +59,12 @@ void BlockDirector::update_single(int player)
 	// Target player's pit object
 	Pit& pit = *m_state->pit().at(player);
 
+	// Nothing happens in a sleeping pit except scrolling, which it does on its own.
+	if(pit.asleep())
+		return;
+
 	// Implementation object for low-level pit examination
-	Logic logic{pit};
+	Logic logic{pit, m_scratch.resource()};
 
 	const long game_time = m_state->game_time();
 
@@ -61,16 +74,14 @@ void BlockDirector::update_single(int player)
 	bool chainstop = false;     // true if the pit should be examined for chain finish
 	bool new_row = false;       // true if a row of blocks has just scrolled to active
 
-	pit.untag_all();
-
+	// All tags from the previous update have been cleared by examine_pit().
 	logic.examine_finish(dead_physical, dead_block, dead_sound, chainstop, new_row);
 
 	// raise until new row, except if player is holding down the button
 	if(new_row)
 		pit.stop_raise();
 
-	auto& pit_contents = pit.contents();
-	const bool have_dissolvers = std::any_of(begin(pit_contents), end(pit_contents), [](const auto& p) { return p->has_tag(Physical::TAG_DISSOLVE); });
+	const bool have_dissolvers = !logic.dissolvers().empty();
 	dead_physical |= have_dissolvers;
 
 	logic.convert_garbage();
@@ -87,8 +98,8 @@ void BlockDirector::update_single(int player)
 	logic.handle_fallers();
 
 	if(m_handler) {
-		pit.for_all(Physical::TAG_LAND, [this, game_time, player](const Physical& p) {
-			m_handler->fire(evt::PhysicalLands{{game_time, player}, p}); });
+		for(const Physical& p : logic.landers())
+			m_handler->fire(evt::PhysicalLands{{game_time, player}, p});
 	}
 
 	bool have_match = false;
@@ -112,8 +123,9 @@ void BlockDirector::update_single(int player)
 	bool breaking = false;      // true if there is any physical in the pit currently breaking
 	bool pit_full = false;      // true if some resting object overflows the pit
 	bool starving = false;      // true if the bottom+1 row is empty based on scrolling
+	bool settled = false;       // true if all physicals are at rest or in preview
 
-	logic.examine_pit(pit_chaining, breaking, pit_full, starving);
+	logic.examine_pit(pit_chaining, breaking, pit_full, starving, settled);
 
 	if(debug_no_gameover)
 		pit_full = false; // debug function: in no-gameover mode, pit is never full
@@ -147,6 +159,11 @@ void BlockDirector::update_single(int player)
 
 	// debug: show what the pit considers to be its peak row
 	pit.highlight(pit.peak());
+
+	// If the next update would come to the same result as this one,
+	// we skip the logic until the pit wakes.
+	if(settled && !pit_chaining && !pit_full && !starving && pit.recovery() <= 0)
+		pit.sleep();
 }
 
 void BlockDirector::apply_input(const PlayerInput& ginput)
@@ -177,7 +194,7 @@ void BlockDirector::apply_input(const PlayerInput& ginput)
 		case GameButton::SWAP:
 			if(ButtonAction::DOWN == ginput.action)
 			{
-				swap(ginput.player);
+				swap(ginput.player, ginput.game_time);
 			}
 
 			break;
@@ -236,7 +253,7 @@ void BlockDirector::apply_input(const SpawnGarbageInput& sginput)
 	garbage.set_state(Physical::State::FALL, ROW_HEIGHT, FALL_SPEED);
 }
 
-bool BlockDirector::swap(int player)
+bool BlockDirector::swap(int player, long game_time)
 {
 	Pit& pit = *m_state->pit().at(player);
 	const RowCol lrc = pit.cursor().rc; // left row/column
@@ -274,7 +291,7 @@ bool BlockDirector::swap(int player)
 	pit.swap(*left, *right);
 
 	if(m_handler)
-		m_handler->fire(evt::Swap{{m_state->game_time(), player}});
+		m_handler->fire(evt::Swap{{game_time, player}});
 
 	return true;
 }
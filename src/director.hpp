@@ -5,6 +5,7 @@
 
 #include "event.hpp"
 #include "input.hpp"
+#include "scratch.hpp"
 
 class GameState;
 class Input;
@@ -51,8 +52,15 @@ public:
 	int winner() const noexcept { return m_winner; }
 	bool over() const noexcept { return NOONE != m_winner; }
 
+	/**
+	 * Forget the outcome of the game after the state has been rolled back.
+	 * Checkpoints always lie before the end of the game.
+	 */
+	void rewind() noexcept { m_winner = NOONE; }
+
 	/**
 	 * Run one tick of game logic over the game state.
+	 * Temporary memory used by the logic is reclaimed at the end.
 	 */
 	void update();
 
@@ -100,6 +108,7 @@ private:
 
 	/**
 	 * Attempt to initiate a swapping action at the player's current cursor coordinates.
+	 * The @c game_time is the time of the input, which the event carries on.
 	 *
 	 * The following conditions must be met for success:
 	 *  - Both blocks must be in a swappable state. These are REST, SWAP, FALL, LAND.
@@ -107,10 +116,11 @@ private:
 	 *
 	 * Returns true if the swap was successful, false otherwise.
 	 */
-	bool swap(int player);
+	bool swap(int player, long game_time);
 
 	GameState* m_state;
 	evt::IEventObserver* m_handler;
 	int m_winner = NOONE; //!< number of the player who wins the game
+	ScratchArena m_scratch{LOGIC_SCRATCH_SIZE}; //!< temporary memory for one tick
 
 };
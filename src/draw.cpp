@@ -40,6 +40,14 @@ void SdlCanvas::draw()
 	sdlok(SDL_RenderCopy(m_renderer, m_texture.get(), NULL, NULL));
 }
 
+SurfacePtr SdlCanvas::read_pixels() const
+{
+	SurfacePtr surface = the_context.sdl->create_surface(CANVAS_W, CANVAS_H);
+	sdlok(SDL_SetRenderTarget(m_renderer, m_texture.get()));
+	sdlok(SDL_RenderReadPixels(m_renderer, nullptr, surface->format->format, surface->pixels, surface->pitch));
+	return surface;
+}
+
 
 SdlDraw::SdlDraw(SDL_Renderer& renderer, const Assets& assets)
 	: m_renderer(&renderer), m_assets(&assets)
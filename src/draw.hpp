@@ -175,6 +175,12 @@ public:
 	virtual void use_as_target() override;
 	virtual void draw() override;
 
+	/**
+	 * Copy the contents of the canvas into a new surface, e.g. to save or
+	 * compare them. Afterwards, the canvas is the rendering target.
+	 */
+	SurfacePtr read_pixels() const;
+
 private:
 
 	TexturePtr m_texture;
@@ -1,6 +1,7 @@
 #include "enet_helper.hpp"
 #include "globals.hpp"
 #include "error.hpp"
+#include <cassert>
 
 namespace
 {
@@ -57,6 +58,37 @@ PacketPtr ENet::create_packet(const std::string &data, ENetPacketFlag flag) cons
 	return move(packet);
 }
 
+PacketPool::Buffer& PacketPool::next_buffer()
+{
+	if(m_free.empty()) {
+		m_buffers.push_back(std::make_unique<Buffer>(Buffer{{}, this}));
+		m_free.reserve(m_buffers.size()); // the release callback must not allocate
+		m_free.push_back(m_buffers.back().get());
+	}
+
+	return *m_free.back();
+}
+
+PacketPtr PacketPool::lend(Buffer& buffer, enet_uint32 flags)
+{
+	assert(!m_free.empty() && &buffer == m_free.back());
+
+	PacketPtr packet{enet_packet_create(buffer.data.c_str(), buffer.data.size() + 1, flags | ENET_PACKET_FLAG_NO_ALLOCATE)};
+	enetok(packet.get());
+
+	packet->userData = &buffer;
+	packet->freeCallback = &PacketPool::release;
+	m_free.pop_back();
+
+	return packet;
+}
+
+void ENET_CALLBACK PacketPool::release(ENetPacket* packet)
+{
+	Buffer* buffer = static_cast<Buffer*>(packet->userData);
+	buffer->pool->m_free.push_back(buffer);
+}
+
 ENet::ENet()
 {
 	enetok(enet_initialize());
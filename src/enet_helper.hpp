@@ -6,6 +6,7 @@
 #include <enet/enet.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 /**
  * Custom deleter for ENet objects, to be used with unique_ptrs.
@@ -61,3 +62,65 @@ private:
 	~ENet();
 
 };
+
+/**
+ * Recycles the data storage of outgoing packets.
+ * The sender writes the packet data straight into a pooled buffer, which the
+ * packet references instead of copying it. When ENet is done with the packet,
+ * even after a broadcast to many peers, the buffer returns to the pool.
+ *
+ * The pool must outlive every packet that it creates. Only the thread which
+ * services the host may use the pool, because ENet frees packets there.
+ */
+class PacketPool
+{
+
+public:
+
+	PacketPool() = default;
+	PacketPool(const PacketPool& ) =delete;
+	PacketPool& operator=(const PacketPool& ) =delete;
+
+	/**
+	 * Create a packet with the given flags from the data that the @c write
+	 * function writes into the std::string it receives.
+	 * The packet data includes the terminating NUL.
+	 */
+	template<typename Write>
+	PacketPtr create_packet(Write write, enet_uint32 flags)
+	{
+		Buffer& buffer = next_buffer();
+		write(buffer.data);
+		return lend(buffer, flags);
+	}
+
+private:
+
+	/**
+	 * Pooled packet data.
+	 */
+	struct Buffer
+	{
+		std::string data;
+		PacketPool* pool; //!< owner, to return to
+	};
+
+	std::vector<std::unique_ptr<Buffer>> m_buffers; //!< all buffers
+	std::vector<Buffer*> m_free; //!< buffers not lent to a packet
+
+	/**
+	 * Return the buffer which the next packet will reference, keeping it in the pool.
+	 */
+	Buffer& next_buffer();
+
+	/**
+	 * Take the buffer out of the pool and create a packet which references it.
+	 */
+	PacketPtr lend(Buffer& buffer, enet_uint32 flags);
+
+	/**
+	 * ENet callback: return the buffer of the destroyed packet to its pool.
+	 */
+	static void ENET_CALLBACK release(ENetPacket* packet);
+
+};
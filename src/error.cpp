@@ -1,9 +1,6 @@
 #include "error.hpp"
 #include "globals.hpp"
 #include "context.hpp"
-#include "asset.hpp"
-#include "sdl_helper.hpp"
-#include "text.hpp"
 #include <fstream>
 #include <sstream>
 #include <thread>
@@ -11,19 +8,7 @@
 #include <cstdarg>
 #include <cassert>
 #include <mutex>
-#include <SDL.h>
-#include <SDL_image.h>
-#include <SDL_ttf.h>
-
-namespace
-{
-
-/**
- * Replace spaces with line breaks after at least the given number of characters in each line.
- */
-void auto_linebreaks(std::string& str, int n);
-
-}
+#include <atomic>
 
 void enforce_impl(bool condition, const char* condition_str, const char* func, const char* file, int line)
 {
@@ -33,30 +18,6 @@ void enforce_impl(bool condition, const char* condition_str, const char* func, c
 
 bool on_failure_break_into_debugger = true;
 
-void sdlok(int result)
-{
-	if(0 != result)
-		throwx<SdlException>();
-}
-
-void sdlok(void* pointer)
-{
-	if(!pointer)
-		throwx<SdlException>();
-}
-
-void imgok(void* pointer)
-{
-	if(!pointer)
-		throwx<SdlException>(IMG_GetError());
-}
-
-void ttfok(void* pointer)
-{
-	if(!pointer)
-		throwx<SdlException>(TTF_GetError());
-}
-
 void enetok_impl(int result, const char* what)
 {
 	if(0 != result)
@@ -69,58 +30,12 @@ void enetok_impl(void* pointer, const char* what)
 		throwx<ENetException>(what);
 }
 
-void show_error(const std::exception& exception) noexcept
+void log_error(const std::exception& exception) noexcept
 {
-	std::string what;
-
-	// put the error message in the log file
 	if(const GameException* game_ex = dynamic_cast<const GameException*>(&exception)) {
-		what = string_format("%s: %s", game_ex->class_name(), game_ex->what());
+		Log::error("%s: %s", game_ex->class_name(), game_ex->what());
 	} else {
-		what = string_format("%s", exception.what());
-	}
-
-	Log::error("%s", what.c_str());
-
-	// display to the user, if we have SDL available.
-	Uint32 init = SDL_WasInit(SDL_INIT_EVERYTHING);
-
-	if(init & SDL_INIT_VIDEO) {
-		SDL_Renderer* renderer = &the_context.sdl->renderer();
-		SDL_Event event;
-		if(0 == SDL_WaitEvent(&event)) return;
-
-		auto_linebreaks(what, 40);
-		TtfText what_text(*the_context.sdl, the_context.assets->ttf_font(), what.c_str());
-
-		do {
-			// rects
-			SDL_Rect outer_rect{30, 30, CANVAS_W - 60, CANVAS_H - 60};
-			SDL_Rect inner_rect{60, 60, CANVAS_W - 120, CANVAS_H - 120};
-			if(0 != SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE)) break;
-			if(0 != SDL_RenderFillRect(renderer, &outer_rect)) break;
-			if(0 != SDL_SetRenderDrawColor(renderer, 255, 0, 0, SDL_ALPHA_OPAQUE)) break;
-			if(0 != SDL_RenderFillRect(renderer, &inner_rect)) break;
-
-			// text
-			SDL_Texture& tex = what_text.texture();
-			Uint32 format;
-			int access;
-			int w;
-			int h;
-			sdlok(SDL_QueryTexture(&tex, &format, &access, &w, &h));
-			const SDL_Rect dest_rect{ 70, CANVAS_H/2 - 40, w, h };
-			sdlok(SDL_RenderCopy(renderer, &tex, NULL, &dest_rect));
-
-			// finish
-			SDL_RenderPresent(renderer);
-
-			if(SDL_QUIT == event.type ||
-				(SDL_KEYDOWN == event.type &&
-				(SDLK_ESCAPE == event.key.keysym.sym || SDLK_RETURN == event.key.keysym.sym))) {
-				break;
-			}
-		} while(SDL_WaitEvent(&event));
+		Log::error("%s", exception.what());
 	}
 }
 
@@ -147,6 +62,9 @@ public:
 	{
 		m_stream.rdbuf()->pubsetbuf(nullptr, 0); // make unbuffered
 		m_stream.open(path, std::ios_base::out | std::ios_base::app);
+		if(!m_stream)
+			throwx<ConfigException>("Cannot open log file %s", path.u8string().c_str());
+
 		write("Log initialized.");
 	}
 
@@ -186,6 +104,23 @@ std::unique_ptr<Logger> create_file_log(std::filesystem::path path)
 namespace Log
 {
 
+namespace
+{
+
+std::atomic<Level> threshold{Level::TRACE}; //!< lowest level that is written
+
+}
+
+void set_level(Level level) noexcept
+{
+	threshold.store(level, std::memory_order_relaxed);
+}
+
+bool enabled(Level level) noexcept
+{
+	return level >= threshold.load(std::memory_order_relaxed);
+}
+
 std::pair<std::string, std::string> write_prerequisites() noexcept
 {
 	// construct date and time string
@@ -243,26 +178,6 @@ std::unique_ptr<GameException> GameException::clone() const
 	return std::make_unique<GameException>(*this);
 }
 
-SdlException::SdlException(const char* what)
-: GameExceptionCloning("%s", what ? what : SDL_GetError())
-{}
-
 EnforceException::EnforceException(const char* condition, const char* func, const char* file, int line)
 	: GameExceptionCloning("Enforced condition violated in %s (%s:%d), expression: \"%s\"", func, file, line, condition)
 {}
-
-namespace
-{
-
-void auto_linebreaks(std::string& str, int n)
-{
-	int last_break = 0;
-	for(int i = 0; i < str.length(); i++) {
-		if(last_break + n <= i && std::isspace(str[i])) {
-			str[i] = '\n';
-			last_break = i;
-		}
-	}
-}
-
-}
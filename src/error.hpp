@@ -138,6 +138,13 @@ void enetok_impl(void* pointer, const char* what);
  */
 void show_error(const std::exception& exception) noexcept;
 
+/**
+ * Write an error log entry for the exception, without involving the user.
+ * Unlike @c show_error, this does not depend on SDL and is available in the
+ * headless server.
+ */
+void log_error(const std::exception& exception) noexcept;
+
 // ================================================
 // Logging
 // ================================================
@@ -163,6 +170,8 @@ std::unique_ptr<Logger> create_no_log();
 
 /**
  * Create a logging implementation that writes to the specified file.
+ *
+ * @throw ConfigException if the file cannot be opened for writing.
  */
 std::unique_ptr<Logger> create_file_log(std::filesystem::path path);
 
@@ -174,6 +183,27 @@ std::unique_ptr<Logger> create_file_log(std::filesystem::path path);
 namespace Log
 {
 
+/**
+ * Severity of log messages, from the most verbose to the most important.
+ */
+enum class Level
+{
+	TRACE, //!< details for debugging
+	INFO,  //!< noteworthy events
+	ERR    //!< failures (not ERROR, which collides with a macro in windows.h)
+};
+
+/**
+ * Only write messages of at least the given level from now on.
+ * By default, all messages are written. Any thread may change the level.
+ */
+void set_level(Level level) noexcept;
+
+/**
+ * Return true if messages of the given level are written.
+ */
+bool enabled(Level level) noexcept;
+
 /**
  * Return a string representation of the current time and current thread id.
  */
@@ -200,22 +230,24 @@ void write(const char* level, const char* format, Args&& ... args) noexcept
 
 /**
  * Write a trace-level log message.
- * If the logger is not intialized, do nothing.
+ * If the logger is not intialized or the level is disabled, do nothing.
  */
 template<typename... Args>
 void trace(const char* format, Args&& ... args) noexcept
 {
-	write("TRACE", format, std::forward<Args>(args)...);
+	if(enabled(Level::TRACE))
+		write("TRACE", format, std::forward<Args>(args)...);
 }
 
 /**
  * Write an info-level log message.
- * If the logger is not intialized, do nothing.
+ * If the logger is not intialized or the level is disabled, do nothing.
  */
 template<typename... Args>
 void info(const char* format, Args&& ... args) noexcept
 {
-	write("INFO", format, std::forward<Args>(args)...);
+	if(enabled(Level::INFO))
+		write("INFO", format, std::forward<Args>(args)...);
 }
 
 /**
@@ -362,6 +394,19 @@ public:
 
 };
 
+/**
+ * Problems in reading binary serialized data.
+ */
+class SerializeException : public GameExceptionCloning<SerializeException>
+{
+
+public:
+
+	EXCEPTION_CONSTRUCT(SerializeException, GameExceptionCloning)
+	EXCEPTION_DEFAULT(SerializeException)
+
+};
+
 /**
  * Umbrella exception for error conditions that arise from use of the SDL library.
  * Their common feature is that they can not be handled and we get the error
@@ -1,6 +1,5 @@
 #include "event.hpp"
 #include "context.hpp"
-#include "stage.hpp"
 #include "audio.hpp"
 
 namespace evt
@@ -18,22 +17,36 @@ void GameEventHub::unsubscribe(IEventObserver& handler)
 }
 
 
-BonusRelay::BonusRelay(Stage& stage)
-	: m_stage(&stage)
-{}
-
-void BonusRelay::fire(evt::Match event)
+void EventQueue::fire(PhysicalLands event)
 {
-	if(event.combo > 3)
-		m_stage->sobs().at(event.trivia.player).bonus.display_combo(event.combo);
+	push(StoredLands{event.trivia, event.physical.clone()});
 }
 
-void BonusRelay::fire(evt::Chain event)
+void EventQueue::replay(IEventObserver& handler)
 {
-	if(event.counter > 0)
-		m_stage->sobs().at(event.trivia.player).bonus.display_chain(event.counter + 1);
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_replaying.swap(m_events);
+	}
+
+	// handle the events without holding the lock, so that the game can go on
+	for(const Event& stored : m_replaying) {
+		std::visit([&handler](const auto& event) {
+			if constexpr(std::is_same_v<const StoredLands&, decltype(event)>)
+				handler.fire(PhysicalLands{event.trivia, *event.physical});
+			else
+				handler.fire(event);
+		}, stored);
+	}
+
+	m_replaying.clear(); // keep the capacity for the next round
 }
 
+void EventQueue::clear()
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	m_events.clear();
+}
 
 void SoundRelay::fire(CursorMoves event)
 {
@@ -64,11 +77,4 @@ void SoundRelay::fire(GarbageDissolves event)
 	the_context.audio->play(Snd::BREAK);
 }
 
-void ShakeRelay::fire(evt::PhysicalLands lands)
-{
-	if(const Garbage* garbage = dynamic_cast<const Garbage*> (&lands.physical)) {
-		m_stage->shake(garbage->rows() * SHAKE_SCALE);
-	}
-}
-
 }
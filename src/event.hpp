@@ -6,6 +6,10 @@
 #pragma once
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <variant>
+#include <vector>
 #include "state.hpp"
 
 class Stage;
@@ -239,6 +243,66 @@ private:
 
 };
 
+/**
+ * A handler for game events that stores them until they are replayed to
+ * another handler, possibly on another thread.
+ * The game thread fires events into the queue while the observing thread
+ * takes them out with @c replay().
+ */
+class EventQueue : public IEventObserver
+{
+
+public:
+
+	virtual void fire(CursorMoves event) override { push(event); }
+	virtual void fire(Swap event) override { push(event); }
+	virtual void fire(Match event) override { push(event); }
+	virtual void fire(Chain event) override { push(event); }
+	virtual void fire(PhysicalLands event) override;
+	virtual void fire(BlockDies event) override { push(event); }
+	virtual void fire(GarbageDissolves event) override { push(event); }
+	virtual void fire(Starve event) override { push(event); }
+	virtual void fire(GameOver event) override { push(event); }
+
+	/**
+	 * Fire all stored events at the handler in their original order and
+	 * remove them from the queue.
+	 * Only one thread at a time may replay the queue.
+	 */
+	void replay(IEventObserver& handler);
+
+	/**
+	 * Discard all stored events.
+	 */
+	void clear();
+
+private:
+
+	/**
+	 * Stored form of @c PhysicalLands with a copy of the physical,
+	 * because the original is subject to change by the game.
+	 */
+	struct StoredLands
+	{
+		Trivia trivia;
+		std::unique_ptr<Physical> physical;
+	};
+
+	using Event = std::variant<CursorMoves, Swap, Match, Chain, StoredLands, BlockDies, GarbageDissolves, Starve, GameOver>;
+
+	template<typename StoredEvent>
+	void push(StoredEvent event)
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_events.emplace_back(std::move(event));
+	}
+
+	std::mutex m_mutex; //!< guards m_events
+	std::vector<Event> m_events; //!< events fired since the last replay
+	std::vector<Event> m_replaying; //!< events being replayed, owned by the replaying thread
+
+};
+
 /**
  * This glue class connects combo and chain events reported by the director (logic)
  * with the BonusIndicator display class.
@@ -5,11 +5,15 @@
 #include "arbiter.hpp"
 #include "network.hpp"
 #include "replay.hpp"
+#include "allocation.hpp"
 #include "error.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <memory>
 #include <optional>
 #include <fstream>
+#include <thread>
 
 IGameFactory::IGameFactory() = default;
 
@@ -128,6 +132,17 @@ BlockDirector& IGame::director()
 	return *m_director;
 }
 
+void IGame::wait_until(std::chrono::steady_clock::time_point deadline)
+{
+	std::this_thread::sleep_until(deadline);
+}
+
+int IGame::input_delay() const
+{
+	enforce(m_meta.has_value());
+	return std::max(0, m_meta->rules.input_delay);
+}
+
 void IGame::before_reset(Handler handler)
 {
 	m_reset_handler = handler;
@@ -162,13 +177,22 @@ void IGame::synchronurse(long target_time)
 
 	// if the state is ahead of the target or the new inputs, roll back
 	const long time0 = std::min(m_journal->earliest_undiscovered(), target_time + 1);
+	bool changed = false; // whether there is anything new to publish
+	std::shared_ptr<const GameState> recent; // the journal's copy of the last simulated tick
 
 	if(time0 <= m_state->game_time()) {
+		AllocationScope scope{AllocPhase::ROLLBACK};
 		const GameState& checkpoint = m_journal->checkpoint_before(time0);
+		const long depth = m_state->game_time() - checkpoint.game_time();
+		m_rollback_stats.rollbacks++;
+		m_rollback_stats.ticks += depth;
+		m_rollback_stats.max_depth = std::max(m_rollback_stats.max_depth, depth);
 		before_rollback(target_time, checkpoint.game_time());
 		Log::trace("%s(%d): revert to checkpoint before time=%d -> at time=%d.", __FUNCTION__, target_time, time0, checkpoint.game_time());
 		*m_state = checkpoint;
+		m_director->rewind();
 		debug_dump_state(*m_state);
+		changed = true;
 	}
 
 	while(m_state->game_time() < target_time && !m_director->over()) {
@@ -185,25 +209,49 @@ void IGame::synchronurse(long target_time)
 		// Run updates based on game logic and interactions.
 		// This may invalidate the above iterators in inputs due to new inputs.
 		m_director->update();
+		changed = true;
+
+		if(m_director->over())
+			break; // stop feeding the journal now
+
+		// Late inputs most likely fall within the last few ticks.
+		// Keep those at hand to roll back only a little.
+		if(may_roll_back() && m_state->game_time() > target_time - static_cast<long>(RECENT_CHECKPOINTS)) {
+			AllocationScope scope{AllocPhase::CHECKPOINT};
+			recent = m_journal->add_recent_checkpoint(*m_state);
+		}
+
+		// Late inputs also remove the sparse checkpoints after them.
+		// Renew those on the way, so that the next rollback need not go back as far.
+		if(m_state->game_time() >= m_journal->last_checkpoint_time() + CHECKPOINT_INTERVAL) {
+			Log::trace("%s(%d): save checkpoint at time=%d.", __FUNCTION__, target_time, m_state->game_time());
+			AllocationScope scope{AllocPhase::CHECKPOINT};
+			m_journal->add_checkpoint(GameState(*m_state));
+			debug_dump_state(*m_state);
+		}
 	}
 
 	m_journal->discover_inputs(target_time + 1);
 
-	if(m_director->over())
-		return; // stop feeding the journal now
+	// Observers only ever see the result of a complete synchronization.
+	// If nobody is looking, the copy would be wasted.
+	if(!changed || !(m_observed.load(std::memory_order_relaxed) || m_feed))
+		return;
 
-	// save new checkpoint?
-	if(target_time >= m_journal->checkpoint_before(target_time).game_time() + CHECKPOINT_INTERVAL) {
-		Log::trace("%s(%d): save checkpoint at time=%d.", __FUNCTION__, target_time, m_state->game_time());
-		m_journal->add_checkpoint(GameState(*m_state));
-		debug_dump_state(*m_state);
-	}
+	// The journal keeps an immutable copy of the same tick for short rollbacks.
+	if(recent && recent->game_time() == m_state->game_time())
+		m_snapshot.publish(std::move(recent));
+	else
+		m_snapshot.publish(*m_state);
+
+	if(m_feed)
+		m_feed->snapshot.share(m_snapshot);
 }
 
 void IGame::load_replay(std::filesystem::path path)
 {
 	if(!std::filesystem::is_regular_file(path)) {
-		throwx<GameException>("Replay not found: %s", path.u8string());
+		throwx<GameException>("Replay not found: %s", path.u8string().c_str());
 	}
 
 	std::ifstream stream{ path };
@@ -245,6 +293,13 @@ void IGame::base_start()
 	enforce(nullptr != m_director);
 	enforce(nullptr != m_hub);
 
+	m_snapshot.publish(*m_state);
+
+	if(m_feed) {
+		m_hub->subscribe(m_feed->events);
+		m_feed->snapshot.share(m_snapshot);
+	}
+
 	if(m_start_handler)
 		m_start_handler();
 }
@@ -257,6 +312,12 @@ void IGame::base_reset()
 	m_switches.ingame = false;
 	m_switches.ready = true;
 
+	m_snapshot.clear();
+	if(m_feed) {
+		m_feed->snapshot.clear();
+		m_feed->events.clear(); // the observer has no use for the old game's events
+	}
+
 	m_state.reset();
 	m_journal.reset();
 	m_director.reset();
@@ -295,7 +356,8 @@ void LocalGame::game_reset(const int players, const Rules rules, const bool repl
 	m_arbiter.reset();
 
 	static std::random_device rdev;
-	m_meta = GameMeta{players, replay ? 0 : rdev(), replay, rules, NOONE};
+	const unsigned seed = replay ? 0 : m_seed.has_value() ? *m_seed : rdev();
+	m_meta = GameMeta{players, seed, replay, rules, NOONE};
 }
 
 void LocalGame::set_speed(int speed)
@@ -337,6 +399,14 @@ void ClientGame::game_start()
 
 void ClientGame::game_input(Input input)
 {
+	// remember when the input left to measure its round trip
+	if(m_switches.ingame) {
+		if(m_unconfirmed.size() >= UNCONFIRMED_INPUTS)
+			m_unconfirmed.pop_front();
+
+		m_unconfirmed.push_back({input, round_trip_clock()});
+	}
+
 	m_protocol->input(input);
 }
 
@@ -353,9 +423,61 @@ void ClientGame::set_speed(int speed)
 
 void ClientGame::poll()
 {
+	AllocationScope scope{AllocPhase::NETWORK_POLL};
 	m_protocol->poll(*this);
 }
 
+void ClientGame::wait_until(std::chrono::steady_clock::time_point deadline)
+{
+	m_protocol->wait_until(deadline);
+}
+
+Connection ClientGame::connection() const
+{
+	return m_protocol->connection();
+}
+
+int ClientGame::input_delay() const
+{
+	enforce(m_meta.has_value());
+
+	if(INPUT_DELAY_AUTO == m_meta->rules.input_delay)
+		return m_auto_delay;
+	else
+		return IGame::input_delay();
+}
+
+long ClientGame::round_trip_clock() const
+{
+	return m_state->game_time();
+}
+
+void ClientGame::measure_round_trip(long ticks)
+{
+	// smoothed round trip time and deviation, like the TCP retransmission timer
+	if(m_round_trip < 0) {
+		m_round_trip = static_cast<double>(ticks);
+		m_round_trip_var = m_round_trip / 2;
+	}
+	else {
+		const double error = ticks - m_round_trip;
+		m_round_trip += error / 8;
+		m_round_trip_var += (std::abs(error) - m_round_trip_var) / 4;
+	}
+
+	// An input sent in one tick comes back before the next tick of the same
+	// number of ticks later. Scheduled that much later, it causes no rollback.
+	const int target = std::min(MAX_INPUT_DELAY, static_cast<int>(std::ceil(m_round_trip + 2 * m_round_trip_var)));
+	const long time = round_trip_clock();
+
+	// Decrease by at most one per tick, so that no input overtakes an earlier one.
+	if(target > m_auto_delay || (target < m_auto_delay && time > m_auto_delay_time)) {
+		m_auto_delay = target > m_auto_delay ? target : m_auto_delay - 1;
+		m_auto_delay_time = time;
+		Log::trace("Adaptive input delay: %d ticks, round trip %.1f ticks.", m_auto_delay, m_round_trip);
+	}
+}
+
 void ClientGame::meta(GameMeta meta)
 {
 	assert(2 == meta.players); // different player numbers are not yet supported
@@ -372,14 +494,41 @@ void ClientGame::input(Input input)
 	if(!m_switches.ingame)
 		throwx<GameException>("Got input from server before the game is running: %s.", std::string(input).c_str());
 
+	if(input.game_time() <= m_journal->horizon())
+		throwx<GameException>("Got input from server before the finalized horizon %d: %s.", m_journal->horizon(), std::string(input).c_str());
+
+	// our own inputs come back from the server in order
+	const auto sent = std::find_if(m_unconfirmed.begin(), m_unconfirmed.end(), [&input](const Unconfirmed& u) { return u.input == input; });
+	if(m_unconfirmed.end() != sent) {
+		measure_round_trip(round_trip_clock() - sent->send_time);
+		m_unconfirmed.erase(m_unconfirmed.begin(), sent + 1);
+	}
+
 	m_journal->add_input(std::move(input));
 }
 
 void ClientGame::retract(long cutoff_time)
 {
+	assert(m_journal);
+
+	if(cutoff_time < m_journal->horizon())
+		throwx<GameException>("Got retract to %d from server before the finalized horizon %d.", cutoff_time, m_journal->horizon());
+
 	m_journal->retract(cutoff_time);
 }
 
+void ClientGame::finalize(long horizon)
+{
+	if(!m_switches.ingame)
+		throwx<GameException>("Got finalize from server while the game is not running.");
+
+	assert(m_journal);
+	if(horizon < m_journal->horizon())
+		throwx<GameException>("Got finalize to %d from server before the finalized horizon %d.", horizon, m_journal->horizon());
+
+	m_journal->finalize(horizon);
+}
+
 void ClientGame::speed(int speed)
 {
 	m_switches.speed = speed;
@@ -398,6 +547,8 @@ void ClientGame::start()
 	Log::info("Initialize new client game for %d players, seed=%u.", m_meta->players, m_meta->seed);
 
 	base_start();
+	m_unconfirmed.clear();
+	m_auto_delay_time = 0;
 }
 
 void ClientGame::gameend(int winner)
@@ -411,6 +562,36 @@ void ClientGame::gameend(int winner)
 	m_switches.winner = winner;
 }
 
+HostGame::HostGame(
+	std::unique_ptr<IGameFactory> game_factory,
+	std::unique_ptr<ClientProtocol> protocol,
+	std::shared_ptr<GameFeed> feed) noexcept
+	:
+	ClientGame(move(game_factory), move(protocol)),
+	m_server_feed(move(feed))
+{
+	enforce(nullptr != m_server_feed);
+}
+
+const SnapshotHandle& HostGame::snapshot() const noexcept
+{
+	return m_server_feed->snapshot;
+}
+
+void HostGame::synchronurse(long target_time)
+{
+	enforce(m_switches.ingame);
+	assert(m_hub);
+
+	m_server_feed->events.replay(*m_hub);
+}
+
+long HostGame::round_trip_clock() const
+{
+	const std::shared_ptr<const GameState> server_state = m_server_feed->snapshot.get();
+	return server_state ? server_state->game_time() : 0;
+}
+
 ServerGame::ServerGame(std::unique_ptr<IGameFactory> game_factory, std::unique_ptr<ServerProtocol> protocol) noexcept
 	: IGame(move(game_factory)), m_protocol(move(protocol))
 {
@@ -443,6 +624,18 @@ void ServerGame::game_input(Input input)
 		throwx<GameException>("Cannot handle input before the game is running: %s.", std::string(input).c_str());
 
 	assert(m_journal);
+
+	// the finalized past is immutable: a late input takes effect right after it
+	const long horizon = m_journal->horizon();
+	if(input.game_time() <= horizon) {
+		if(0 == input.source())
+			throwx<GameException>("Cannot handle arbiter input before the finalized horizon %d: %s.", horizon, std::string(input).c_str());
+
+		PlayerInput late = input.get<PlayerInput>();
+		late.game_time = horizon + 1;
+		input = Input{late};
+	}
+
 	m_journal->add_input(input);
 
 	m_protocol->input(input);
@@ -456,7 +649,8 @@ void ServerGame::game_reset(const int players, const Rules rules, const bool rep
 		throwx<GameException>("%d players are currently not supported.", players);
 
 	static std::random_device rdev;
-	m_meta = GameMeta{players, replay ? 0 : rdev(), replay, rules, NOONE};
+	const unsigned seed = replay ? 0 : m_seed.has_value() ? *m_seed : rdev();
+	m_meta = GameMeta{players, seed, replay, rules, NOONE};
 	m_protocol->meta(*m_meta);
 }
 
@@ -468,6 +662,8 @@ void ServerGame::set_speed(int speed)
 
 void ServerGame::poll()
 {
+	AllocationScope scope{AllocPhase::NETWORK_POLL};
+
 	// TODO: on error, properly discard the message and offending client
 	m_protocol->poll(*this);
 
@@ -483,6 +679,27 @@ void ServerGame::poll()
 	}
 }
 
+void ServerGame::wait_until(std::chrono::steady_clock::time_point deadline)
+{
+	m_protocol->wait_until(deadline);
+}
+
+void ServerGame::synchronurse(long target_time)
+{
+	IGame::synchronurse(target_time);
+
+	if(target_time <= FINALIZE_DELAY)
+		return;
+
+	// The horizon is always the time of a checkpoint. Any later rollback starts
+	// from that checkpoint or after it, so it never retracts final inputs.
+	const long horizon = m_journal->checkpoint_before(target_time - FINALIZE_DELAY + 1).game_time();
+	if(horizon > m_journal->horizon()) {
+		m_journal->finalize(horizon);
+		m_protocol->finalize(horizon);
+	}
+}
+
 void ServerGame::before_rollback(long target_time, long checkpoint_time)
 {
 	m_protocol->retract(checkpoint_time);
@@ -2,23 +2,19 @@
 
 #include <memory>
 #include <functional>
+#include <deque>
+#include <atomic>
 #include "globals.hpp"
+#include "state.hpp"
 #include "input.hpp"
 #include "network.hpp"
+#include "event.hpp"
 
 // forward declarations
 class BlockDirector;
-class GameState;
 class Journal;
 class IArbiter;
 
-namespace evt
-{
-
-class GameEventHub;
-
-}
-
 /**
  * An abstract factory that can create dependencies for a @c Game tailored to
  * a specific scenario, like production or testing.
@@ -120,6 +116,28 @@ struct Switches
 	int winner = NOONE; //!< if the game is over, contains the index of the winner
 };
 
+/**
+ * Counters of the rollbacks in @c IGame::synchronurse, for measurements.
+ */
+struct RollbackStats
+{
+	long rollbacks = 0; //!< number of times the state went back to a checkpoint
+	long ticks = 0;     //!< total number of ticks which had to be calculated again
+	long max_depth = 0; //!< most ticks calculated again after one rollback
+};
+
+/**
+ * Read-only view of a game for observers on another thread.
+ * The game keeps it up to date with its snapshots and events.
+ * The view outlives the game, so that the observer need not care
+ * when the game goes away.
+ */
+struct GameFeed
+{
+	SnapshotHandle snapshot; //!< latest state published by the game
+	evt::EventQueue events; //!< events which the observer has yet to take
+};
+
 /**
  * Interface for classes that implement a game session.
  *
@@ -150,6 +168,27 @@ public:
 	 */
 	const GameState& state() const;
 
+	/**
+	 * Return the handle to the latest published game state.
+	 * Unlike @c state(), the snapshots are safe to read from outside the
+	 * simulation, even while @c synchronurse rewinds the live state.
+	 * The handle itself lives as long as the game object.
+	 * Between games, it holds no snapshot.
+	 * The game only publishes snapshots once someone has asked for the handle.
+	 */
+	virtual const SnapshotHandle& snapshot() const noexcept
+	{
+		m_observed.store(true, std::memory_order_relaxed);
+		return m_snapshot;
+	}
+
+	/**
+	 * Keep the given feed up to date with this game from the next start on.
+	 * The feed receives all published snapshots and game events.
+	 * This must be set up before the game runs on another thread.
+	 */
+	void set_feed(std::shared_ptr<GameFeed> feed) noexcept { m_feed = std::move(feed); }
+
 	/**
 	 * Return the record of game events and checkpoints.
 	 * This reference is valid as long as the current game is ongoing or over.
@@ -228,6 +267,28 @@ public:
 	 */
 	virtual void poll() = 0;
 
+	/**
+	 * Wait until new external messages may be available to @c poll(), but no
+	 * longer than until the deadline.
+	 * Games without a remote end simply sleep until the deadline.
+	 */
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline);
+
+	/**
+	 * Return the state of the connection to the remote game.
+	 * Games without a remote end are always connected.
+	 */
+	virtual Connection connection() const { return Connection::CONNECTED; }
+
+	/**
+	 * Return the number of ticks by which the game schedules local inputs
+	 * later than they happen, according to @c Rules::input_delay.
+	 * Games without a remote end do not adapt the delay.
+	 *
+	 * @throw EnforceException if the game is neither ready nor in progress.
+	 */
+	virtual int input_delay() const;
+
 	/**
 	 * Callback type for changes in the game state machine.
 	 */
@@ -249,7 +310,12 @@ public:
 	 *
 	 * @throw EnforceException if the game is not in progress.
 	 */
-	void synchronurse(long target_time);
+	virtual void synchronurse(long target_time);
+
+	/**
+	 * Return the rollback counters of this game object over all games so far.
+	 */
+	const RollbackStats& rollback_stats() const noexcept { return m_rollback_stats; }
 
 	/**
 	 * Read the replay from the given replay file.
@@ -287,12 +353,22 @@ protected:
 	 */
 	virtual void before_rollback(long target_time, long checkpoint_time) {}
 
+	/**
+	 * Return true if inputs can arrive late and make @c synchronurse roll back.
+	 * Only then does the game keep recent checkpoints for short rollbacks.
+	 */
+	virtual bool may_roll_back() const noexcept { return true; }
+
 	std::optional<GameMeta> m_meta; //!< game meta-info, available when ready or ingame
 	std::unique_ptr<IGameFactory> m_game_factory; //!< creates dependencies in @c base_start
 	std::unique_ptr<GameState> m_state; //!< game state object, non-null ingame
+	SnapshotHandle m_snapshot; //!< read-only copy of the state for observers
+	mutable std::atomic<bool> m_observed{false}; //!< whether anyone has asked for m_snapshot
 	std::unique_ptr<Journal> m_journal; //!< game record, non-null ingame
 	std::unique_ptr<BlockDirector> m_director; //!< game rules implementation
 	std::unique_ptr<evt::GameEventHub> m_hub; //!< game events subscriptions, non-null ingame
+	std::shared_ptr<GameFeed> m_feed; //!< optional view for observers on another thread
+	RollbackStats m_rollback_stats; //!< measurements of synchronurse
 
 };
 
@@ -317,13 +393,25 @@ public:
 	virtual void set_speed(int speed) override;
 	virtual void poll() override;
 
+	/**
+	 * Use the given random seed for all following games instead of a fresh
+	 * random one, e.g. to make benchmarks reproducible.
+	 */
+	void set_seed(unsigned seed) noexcept { m_seed = seed; }
+
 protected:
 
 	virtual void before_rollback(long target_time, long checkpoint_time) override;
 
+	/**
+	 * All inputs of a local game arrive in time, so it never rolls back.
+	 */
+	virtual bool may_roll_back() const noexcept override { return false; }
+
 private:
 
 	std::unique_ptr<IArbiter> m_arbiter; //!< centralized decision component, non-null ingame
+	std::optional<unsigned> m_seed; //!< fixed seed for new games, if set
 
 };
 
@@ -350,21 +438,106 @@ public:
 	virtual void game_reset(int players, Rules rules, bool replay) override;
 	virtual void set_speed(int speed) override;
 	virtual void poll() override;
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline) override;
+	virtual Connection connection() const override;
+
+	/**
+	 * Return the input delay from the rules or, in adaptive mode, the delay
+	 * which covers the round trip of local inputs through the server.
+	 */
+	virtual int input_delay() const override;
+
+protected:
+
+	/**
+	 * Return the game time by which we measure the round trip of inputs.
+	 * This is the time of our own game state.
+	 */
+	virtual long round_trip_clock() const;
 
 private:
 
+	/**
+	 * Local input on its way to the server and back.
+	 */
+	struct Unconfirmed
+	{
+		Input input;
+		long send_time; //!< round trip clock when we sent the input
+	};
+
 	std::unique_ptr<ClientProtocol> m_protocol; //!< communicator object
+	std::deque<Unconfirmed> m_unconfirmed; //!< sent inputs, oldest first
+	double m_round_trip = -1; //!< smoothed round trip time in ticks, negative before the first sample
+	double m_round_trip_var = 0; //!< smoothed deviation of the round trip time
+	int m_auto_delay = 0; //!< current input delay in adaptive mode
+	long m_auto_delay_time = 0; //!< game time of the latest change to the adaptive delay
+
+	/**
+	 * Update the adaptive input delay from the round trip time of one input.
+	 */
+	void measure_round_trip(long ticks);
 
 	// IServerMessages member functions - handlers for incoming messages
 	virtual void meta(GameMeta meta) override;
 	virtual void input(Input input) override;
 	virtual void retract(long cutoff_time) override;
+	virtual void finalize(long horizon) override;
 	virtual void speed(int speed) override;
 	virtual void start() override;
 	virtual void gameend(int winner) override;
 
 };
 
+/**
+ * Client game implementation for the player who also hosts the server.
+ *
+ * Instead of simulating the game a second time in the same process, the host
+ * shows the server game through its feed. The client part still sends the
+ * player's inputs to the server and records the journal from the server's
+ * messages, but it keeps no checkpoints and never rolls back.
+ */
+class HostGame : public ClientGame
+{
+
+public:
+
+	/**
+	 * Construct the game to communicate via the given protocol and
+	 * to show the server game from the given feed.
+	 */
+	explicit HostGame(
+		std::unique_ptr<IGameFactory> game_factory,
+		std::unique_ptr<ClientProtocol> protocol,
+		std::shared_ptr<GameFeed> feed) noexcept;
+
+	/**
+	 * Return the handle to the snapshots of the server game.
+	 */
+	virtual const SnapshotHandle& snapshot() const noexcept override;
+
+	/**
+	 * Deliver the events of the server game since the last call to our hub.
+	 * The server game advances on its own, so the target time is irrelevant.
+	 *
+	 * @throw EnforceException if the game is not in progress.
+	 */
+	virtual void synchronurse(long target_time) override;
+
+protected:
+
+	/**
+	 * Return the time of the latest snapshot of the server game.
+	 * Our own game state never advances.
+	 */
+	virtual long round_trip_clock() const override;
+
+private:
+
+	std::shared_ptr<GameFeed> m_server_feed; //!< view of the server game
+
+};
+
 /**
  * Server game implementation.
  *
@@ -387,6 +560,20 @@ public:
 	virtual void game_reset(int players, Rules rules, bool replay) override;
 	virtual void set_speed(int speed) override;
 	virtual void poll() override;
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline) override;
+
+	/**
+	 * Update the game like @c IGame::synchronurse.
+	 * Then declare the game final up to the latest checkpoint that is at least
+	 * @c FINALIZE_DELAY ticks old and announce the new horizon to the clients.
+	 */
+	virtual void synchronurse(long target_time) override;
+
+	/**
+	 * Use the given random seed for all following games instead of a fresh
+	 * random one, e.g. to make benchmarks reproducible.
+	 */
+	void set_seed(unsigned seed) noexcept { m_seed = seed; }
 
 protected:
 
@@ -396,6 +583,7 @@ private:
 
 	std::unique_ptr<IArbiter> m_arbiter;  //!< centralized decision component, non-null ingame
 	std::unique_ptr<ServerProtocol> m_protocol; //!< communicator object
+	std::optional<unsigned> m_seed; //!< fixed seed for new games, if set
 
 	// IClientMessages member functions - handlers for incoming messages
 	virtual void meta(GameMeta meta) override;
@@ -2,10 +2,13 @@
 #include "replay.hpp"
 #include "arbiter.hpp"
 #include "game.hpp"
+#include "allocation.hpp"
 #include "error.hpp"
 #include "context.hpp"
 #include "configuration.hpp"
 #include <fstream>
+#include <thread>
+#include <chrono>
 #include <SDL.h> // DEBUG
 
 GameLoop::GameLoop()
@@ -52,34 +55,34 @@ void GameLoop::game_loop()
 			assert(fraction >= 0);
 			assert(fraction <= 1);
 
-			m_screen->draw(fraction);
+			{
+				AllocationScope scope{AllocPhase::DRAW};
+				m_screen->draw(fraction);
+			}
 			now = SDL_GetPerformanceCounter();
 
-			// yield CPU if we have the time
-			if(now < next_logic) {
+			// yield CPU if we have the time, but wake up for any input
+			while(now < next_logic) {
 				Uint64 wait = (next_logic - now) * 1000L / freq; // in ms
-				assert(wait <= std::numeric_limits<Uint32>::max());
-				SDL_Delay(static_cast<Uint32>(wait));
+				assert(wait <= static_cast<Uint64>(std::numeric_limits<int>::max()));
+				if(wait > 0) {
+					SDL_WaitEventTimeout(nullptr, static_cast<int>(wait));
+				}
+				else {
+					// SDL only waits in whole milliseconds. Sleep through the rest instead of spinning.
+					std::this_thread::sleep_for(std::chrono::nanoseconds((next_logic - now) * 1000000000L / freq));
+				}
+				deliver_inputs();
 				now = SDL_GetPerformanceCounter();
 			}
 		}
 
-		// get different sources of input
-		const auto inputs = m_input_devices.poll();
-		for(auto i : inputs) {
-			// Debug functionality: take control of a certain player.
-			// F2 key: take control of player 0
-			// F3 key: take control of player 1
-			if(Button::DEBUG2 == i.button && ButtonAction::DOWN == i.action)
-				m_input_devices.set_player_number(0);
-			else if(Button::DEBUG3 == i.button && ButtonAction::DOWN == i.action)
-				m_input_devices.set_player_number(1);
-
-			m_screen->input(i);
-		}
+		// inputs which arrived while drawing
+		deliver_inputs();
 
 		// run one frame of local logic
 		m_screen->update();
+		allocation_tick();
 
 		if(m_screen->done()) {
 			m_screen = m_screen_factory.create_next(*m_screen);
@@ -95,3 +98,20 @@ void GameLoop::game_loop()
 
 	Log::info("Game exit.");
 }
+
+void GameLoop::deliver_inputs()
+{
+	// get different sources of input
+	const auto inputs = m_input_devices.poll();
+	for(auto i : inputs) {
+		// Debug functionality: take control of a certain player.
+		// F2 key: take control of player 0
+		// F3 key: take control of player 1
+		if(Button::DEBUG2 == i.button && ButtonAction::DOWN == i.action)
+			m_input_devices.set_player_number(0);
+		else if(Button::DEBUG3 == i.button && ButtonAction::DOWN == i.action)
+			m_input_devices.set_player_number(1);
+
+		m_screen->input(i);
+	}
+}
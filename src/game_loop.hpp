@@ -28,6 +28,13 @@ public:
 
 private:
 
+	/**
+	 * Read all available inputs and hand them to the active screen right away.
+	 * They belong to the next logic tick, no matter how late they arrive,
+	 * because that is the earliest tick which is not simulated yet.
+	 */
+	void deliver_inputs();
+
 	// resources
 	InputDevices m_input_devices;
 
@@ -86,7 +86,7 @@ Color string_to_color(const std::string& source)
 std::string GameMeta::to_string() const
 {
 	std::ostringstream ss;
-	ss << players << " " << seed << " " << (replay ? "true" : "false") << " " << rules.cursor_delay << " " << winner;
+	ss << players << " " << seed << " " << (replay ? "true" : "false") << " " << rules.cursor_delay << " " << winner << " " << rules.input_delay;
 	return ss.str();
 }
 
@@ -103,7 +103,12 @@ GameMeta GameMeta::from_string(std::string meta_string)
 	if(!tokenizer)
 		throwx<GameException>("Invalid GameMeta string: \"%s\"", meta_string.c_str());
 
-	const Rules rules{ cursor_delay };
+	// older replays do not have the input delay
+	int input_delay = 0;
+	if(!(tokenizer >> input_delay))
+		input_delay = 0;
+
+	const Rules rules{ cursor_delay, input_delay };
 	return GameMeta{players, seed, replay, rules, winner};
 }
 
@@ -19,10 +19,21 @@
 constexpr const char* APP_NAME = "shitbrix";
 constexpr int TPS = 30; // fixed number of logic ticks per second (game speed)
 constexpr long CHECKPOINT_INTERVAL = 1 * TPS; //!< time between checkpoints for journal
+constexpr size_t RECENT_CHECKPOINTS = 8; //!< number of most recent ticks with a checkpoint for short rollbacks
+constexpr long FINALIZE_DELAY = 3 * TPS; //!< age at which the server declares ticks final, more than any expected input lag
+constexpr int MAX_INPUT_DELAY = TPS / 2; //!< most ticks by which local inputs may be scheduled late
+constexpr int INPUT_DELAY_AUTO = -1; //!< input delay setting which adapts to the round trip time
+constexpr size_t UNCONFIRMED_INPUTS = 64; //!< sent inputs which a client remembers to measure their round trip
 constexpr size_t MAX_CLIENTS = 8; //!< maximum number of networked players
 constexpr uint16_t DEFAULT_PORT = 2414; //!< network port for connections
-constexpr uint32_t CONNECT_TIMEOUT = 5000; //!< peer to server connection time limit
+constexpr uint32_t CONNECT_TIMEOUT = 5000; //!< peer to server connection time limit per attempt
+constexpr int CONNECT_ATTEMPTS = 4; //!< number of attempts to connect to the server
+constexpr uint32_t CONNECT_BACKOFF = 500; //!< wait time in ms before the first retry, doubles with every retry
 constexpr uint8_t MESSAGE_CHANNEL = 1; //!< network communication channel for gameplay messages
+constexpr size_t NET_QUEUE_CAPACITY = 256; //!< messages in flight between the simulation and the network I/O thread
+constexpr uint32_t NET_IO_INTERVAL = 1; //!< time in ms between network services on the I/O thread, unless woken earlier
+constexpr size_t LOGIC_SCRATCH_SIZE = 32 * 1024; //!< bytes of temporary memory for one tick of game logic
+constexpr size_t ARBITER_SCRATCH_SIZE = 2 * 1024; //!< bytes of temporary memory for one arbiter decision
 
 // Gameplay constants
 constexpr int PIT_COLS = 6; //!< number of blocks that fit in a pit next to each other
@@ -289,6 +300,26 @@ constexpr int BITMAP_FONT_LINEHEIGHT = 25; //!< Pixel height of one line in bmp
 struct Rules
 {
 	int cursor_delay = 0; //!< number of updates between cursor moves
+	int input_delay = 0; //!< ticks between a local input and its effect, or @c INPUT_DELAY_AUTO
+};
+
+/**
+ * Adverse network conditions for testing, see @c make_conditioned_channel.
+ * The default values describe a perfect network.
+ */
+struct NetConditions
+{
+	int latency = 0;     //!< one-way delay of every message in ms
+	int jitter = 0;      //!< maximum random delay in ms on top of the latency
+	int loss = 0;        //!< percentage of messages lost in transit
+	int duplication = 0; //!< percentage of messages which arrive twice
+	int reordering = 0;  //!< percentage of messages held back behind later ones
+	bool reliable = true; //!< emulate reliable delivery: resend lost messages, keep the order, drop duplicates
+
+	/**
+	 * Return true if these conditions have any effect on the messages.
+	 */
+	bool active() const noexcept { return latency > 0 || jitter > 0 || loss > 0 || duplication > 0 || reordering > 0; }
 };
 
 /**
@@ -147,6 +147,13 @@ public:
 	 */
 	long game_time() const;
 
+	/**
+	 * Return the origin of the input: 0 for decisions of the arbiter,
+	 * player number + 1 for player inputs.
+	 * Every source delivers its own inputs in order.
+	 */
+	int source() const noexcept;
+
 	/**
 	 * Retrieve the contained input of the given type.
 	 */
@@ -1,5 +1,8 @@
 #include "logic.hpp"
 #include "error.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <cassert>
 
 namespace
@@ -65,43 +68,80 @@ void MatchBuilder::insert(RowCol rc)
 
 void Logic::trigger_falls(RowCol rc, bool chaining) const
 {
-	Physical* physical = m_pit.at(rc);
-
-	if(!physical ||
-	   !physical->is_fallible() ||
-	   Physical::State::DEAD == physical->physical_state())
+	if(rc.c < 0 || rc.c >= PIT_COLS)
 		return;
 
-	// If this is part of a chaining move, we have to set the chaining flag on
-	// the block *now* before we forget what the reason for the falling was.
-	// If the block does not end up really falling after all, re-evaluate.
-	if(Block* block = dynamic_cast<Block*>(physical))
-		block->chaining |= chaining;
+	// Sweep the pit from the bottom up. For every column, remember the next
+	// row which we have yet to examine. A column goes idle when the sweep
+	// meets a slot which cannot fall. Physicals which we have already visited
+	// are tagged with TAG_FALL, so is_fallible() skips them on every later
+	// visit within the same tick, e.g. from another column of a wide garbage.
+	// The tags are the only information which later triggers in the tick reuse.
+	// Rows at which a column went idle cannot be kept: between triggers, the
+	// caller changes the pit, e.g. by shrinking garbage and spawning its loot.
+	constexpr int NO_ROW = std::numeric_limits<int>::min();
+	std::array<int, PIT_COLS> next_row;
+	next_row.fill(NO_ROW);
+	next_row[rc.c] = rc.r;
+
+	for(int r = rc.r; NO_ROW != r; r = *std::max_element(next_row.begin(), next_row.end())) {
+		for(int c = 0; c < PIT_COLS; c++) {
+			if(r != next_row[c])
+				continue;
+
+			next_row[c] = NO_ROW;
+			Physical* physical = m_pit.at({r, c});
+
+			if(!physical ||
+			   !physical->is_fallible() ||
+			   Physical::State::DEAD == physical->physical_state())
+				continue;
+
+			// If this is part of a chaining move, we have to set the chaining flag on
+			// the block *now* before we forget what the reason for the falling was.
+			// If the block does not end up really falling after all, re-evaluate.
+			if(Block* block = dynamic_cast<Block*>(physical))
+				block->chaining |= chaining;
 
-	physical->set_tag(Physical::TAG_FALL);
+			physical->set_tag(Physical::TAG_FALL);
 
-	rc = physical->rc();
-	for(int c = rc.c; c < rc.c + physical->columns(); c++) {
-		trigger_falls(RowCol{rc.r - 1, c}, chaining);
+			// Everything on top of the physical is next. Since the sweep goes
+			// strictly upwards, no pending row in these columns is lost.
+			const RowCol top_rc = physical->rc();
+			for(int pc = top_rc.c; pc < top_rc.c + physical->columns(); pc++) {
+				next_row[pc] = top_rc.r - 1;
+			}
+		}
 	}
 }
 
-void Logic::examine_pit(bool& chaining, bool& breaking, bool& full, bool& starving) const noexcept
+void Logic::examine_pit(bool& chaining, bool& breaking, bool& full, bool& starving, bool& settled) noexcept
 {
+	const int top = m_pit.top();
+	settled = true;
+
 	for(const auto& ptr : m_pit.contents()) {
+		const Physical::State state = ptr->physical_state();
+
 		if(Block* b = dynamic_cast<Block*>(ptr.get())) {
 			chaining |= b->chaining;
+			settled &= Physical::State::REST == state || Block::State::PREVIEW == b->block_state();
+		}
+		else {
+			settled &= Physical::State::REST == state;
 		}
 
-		breaking |= ptr->physical_state() == Physical::State::BREAK;
+		breaking |= Physical::State::BREAK == state;
+		full |= Pit::overflows(*ptr, top);
+
+		ptr->clear_tags();
 	}
 
-	full = m_pit.is_full();
 	starving = !m_pit.at({m_pit.bottom() + 1, 0}); // check one slot is enough
 }
 
 void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sound,
-                           bool& chainstop, bool& new_row) const
+                           bool& chainstop, bool& new_row)
 {
 	for(auto& physical : m_pit.contents())
 	{
@@ -118,7 +158,7 @@ void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sou
 			// this only takes effect with blocks that actually land.
 			physical->set_tag(Physical::TAG_FALL);
 			if(Block* block = dynamic_cast<Block*>(&*physical))
-				block->set_tag(Physical::TAG_HOT);
+				make_hot(*block);
 		}
 
 		// Garbage-specifics
@@ -126,6 +166,7 @@ void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sou
 			// shrink garbage if necessary
 			if(Physical::State::BREAK == garbage->physical_state() && is_arriving) {
 				garbage->set_tag(Physical::TAG_DISSOLVE);
+				m_dissolvers.emplace_back(*garbage);
 			}
 		}
 
@@ -138,7 +179,7 @@ void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sou
 			// new blocks become active
 			if(Block::State::PREVIEW == state && m_pit.bottom() == block->rc().r) {
 				block->set_state(Block::State::REST);
-				block->set_tag(Physical::Tag::TAG_HOT);
+				make_hot(*block);
 				new_row = true;
 			}
 
@@ -152,7 +193,7 @@ void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sou
 				}
 				else {
 					block->set_tag(Physical::TAG_FALL);
-					block->set_tag(Physical::TAG_HOT);
+					make_hot(*block);
 
 					above_fall = true;
 				}
@@ -187,22 +228,17 @@ void Logic::examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sou
 	}
 }
 
-void Logic::convert_garbage() const
+void Logic::convert_garbage()
 {
-	std::vector<std::reference_wrapper<Garbage>> converts;
-
-	// be careful not to iterate at the same time as we change contents
-	m_pit.for_all<Garbage>(Physical::TAG_DISSOLVE, [&converts](Garbage& garbage) {
-		converts.emplace_back(garbage);
-	});
-
-	for(Garbage& garbage : converts) {
+	for(Garbage& garbage : m_dissolvers) {
 		RowCol garbage_rc = garbage.rc();
 		int garbage_columns = garbage.columns();
 		int garbage_rows = garbage.rows();
 		auto loot_it = garbage.loot();
-		Loot loot(loot_it, loot_it + garbage_columns);
-		bool survived = m_pit.shrink(garbage) > 0;
+		assert(garbage_columns <= PIT_COLS);
+		std::array<Color, PIT_COLS> loot;
+		std::copy(loot_it, loot_it + garbage_columns, loot.begin());
+		bool survived = nullptr != m_pit.shrink(garbage);
 
 		for(int c = 0; c < garbage_columns; c++) {
 			// extract loot into bottom row of garbage
@@ -210,7 +246,7 @@ void Logic::convert_garbage() const
 			Block& block = m_pit.spawn_block(loot[c], block_rc, Block::State::REST);
 			block.chaining = true;
 			block.set_tag(Physical::TAG_FALL);
-			block.set_tag(Physical::TAG_HOT);
+			make_hot(block);
 
 			// consider falling for everything above garbage
 			trigger_falls({garbage_rc.r - 1, c}, true);
@@ -224,15 +260,21 @@ void Logic::convert_garbage() const
 	}
 }
 
-void Logic::handle_fallers() const
+void Logic::handle_fallers()
 {
+	PhysicalRefVec fallers(m_memory);
+
+	m_pit.for_all(Physical::TAG_FALL, [&fallers](Physical& physical) {
+		fallers.emplace_back(physical);
+	});
+
 	bool changed = true;
 
 	while(changed) {
 		changed = false;
 
-		m_pit.for_all(Physical::TAG_FALL, [this, &changed](Physical& physical) {
-			if(m_pit.can_fall(physical)) {
+		for(Physical& physical : fallers) {
+			if(physical.has_tag(Physical::TAG_FALL) && m_pit.can_fall(physical)) {
 				// If the object is already falling, we do not wish to throw
 				// away the slice of their time in which they already fell
 				// into the next row.
@@ -249,15 +291,19 @@ void Logic::handle_fallers() const
 
 				changed = true;
 			}
-		});
+		}
 	}
 
-	m_pit.for_all(Physical::TAG_FALL, [](Physical& physical) {
+	for(Physical& physical : fallers) {
+		if(!physical.has_tag(Physical::TAG_FALL))
+			continue;
+
 		Physical::State state = physical.physical_state();
 
 		if(Physical::State::FALL == state) {
 			physical.set_state(Physical::State::LAND, LAND_TIME);
 			physical.set_tag(Physical::TAG_LAND);
+			m_landers.emplace_back(physical);
 		}
 		else {
 			physical.set_state(Physical::State::REST);
@@ -267,25 +313,23 @@ void Logic::handle_fallers() const
 			if(Block* block = dynamic_cast<Block*>(&physical))
 				block->chaining = false;
 		}
-	});
+	}
 
 	// blocks cannot match if they are falling down!
-	auto& contents = m_pit.contents();
-	for(auto it = std::begin(contents), e = std::end(contents); it != e; ++it) {
-		Physical& physical = **it;
-
-		if(Physical::State::FALL == physical.physical_state())
-			physical.un_tag(Physical::TAG_HOT);
+	for(Block& block : m_hots) {
+		if(Physical::State::FALL == block.physical_state())
+			block.un_tag(Physical::TAG_HOT);
 	}
 }
 
-void Logic::handle_hots(bool& have_match, int& combo, bool& chaining, bool& chainstop) const
+void Logic::handle_hots(bool& have_match, int& combo, bool& chaining, bool& chainstop)
 {
-	MatchBuilder builder(m_pit);
+	MatchBuilder builder(m_pit, m_memory);
 
-	m_pit.for_all<Block>(Physical::TAG_HOT, [&builder](Block& block) {
-		builder.ignite(block);
-	});
+	for(Block& block : m_hots) {
+		if(block.has_tag(Physical::TAG_HOT))
+			builder.ignite(block);
+	}
 
 	auto& breaks = builder.result();
 	combo = builder.combo();
@@ -305,25 +349,35 @@ void Logic::handle_hots(bool& have_match, int& combo, bool& chaining, bool& chai
 	}
 
 	// There is only 1 chance per block to make a chain
-	m_pit.for_all<Block>(Physical::TAG_HOT, [&chainstop](Block& block) {
+	for(Block& block : m_hots) {
 		// Chaining blocks which come to rest can finish a chain.
 		// Blocks which have now matched are still carrying the chain.
-		if(block.chaining && Block::State::BREAK != block.block_state()) {
+		if(block.has_tag(Physical::TAG_HOT) &&
+		   block.chaining && Block::State::BREAK != block.block_state()) {
 			block.chaining = false;
 			chainstop = true;
 		}
-	});
+	}
 
 	// execute on the breaking of touched garbages
-	m_pit.for_all<Garbage>(Physical::TAG_TOUCH, [](Garbage& garbage) {
+	for(Garbage& garbage : m_touched) {
 		garbage.set_state(Physical::State::BREAK, DISSOLVE_TIME);
-	});
+	}
+}
+
+void Logic::make_hot(Block& block)
+{
+	if(!block.has_tag(Physical::TAG_HOT)) {
+		block.set_tag(Physical::TAG_HOT);
+		m_hots.emplace_back(block);
+	}
 }
 
-void Logic::touch_garbage(Garbage& garbage) const
+void Logic::touch_garbage(Garbage& garbage)
 {
 	if(!garbage.has_tag(Physical::TAG_TOUCH)) {
 		garbage.set_tag(Physical::TAG_TOUCH);
+		m_touched.emplace_back(garbage);
 		for_neighbors<Garbage>(m_pit, garbage, [this](Garbage& g) { touch_garbage(g); });
 	}
 };
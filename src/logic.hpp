@@ -6,12 +6,14 @@
 
 #include "state.hpp"
 #include <unordered_set>
+#include <memory_resource>
 
 /**
  * Examines the pit for matching blocks from a sequence of hot blocks
  * which have just been moved or landed. They are passed to the MatchBuilder via ignite(). 
  * Returns all detected matching blocks (3 or more in a row from a hot block) in result().
  * The combo() specifies the number of blocks resolved at the same time.
+ * The result set lives in the given memory resource.
  */
 class MatchBuilder
 {
@@ -36,10 +38,11 @@ private:
 
 public:
 
-	using BlockSet = std::unordered_set<std::reference_wrapper<Block>, PhysHash, PhysEqual>;
-	using GarbageSet = std::unordered_set<std::reference_wrapper<Garbage>, PhysHash, PhysEqual>;
+	using BlockSet = std::pmr::unordered_set<std::reference_wrapper<Block>, PhysHash, PhysEqual>;
+	using GarbageSet = std::pmr::unordered_set<std::reference_wrapper<Garbage>, PhysHash, PhysEqual>;
 
-	MatchBuilder(const Pit& pit) : pit(pit), m_chaining(false) {}
+	explicit MatchBuilder(const Pit& pit, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+		: pit(pit), m_result(memory), m_chaining(false) {}
 
 	void ignite(Block& block);
 	const BlockSet& result() { return m_result; }
@@ -58,9 +61,9 @@ private:
 
 };
 
-using PhysicalRefVec = std::vector<std::reference_wrapper<Physical>>;
-using BlockRefVec = std::vector<std::reference_wrapper<Block>>;
-using GarbageRefVec = std::vector<std::reference_wrapper<Garbage>>;
+using PhysicalRefVec = std::pmr::vector<std::reference_wrapper<Physical>>;
+using BlockRefVec = std::pmr::vector<std::reference_wrapper<Block>>;
+using GarbageRefVec = std::pmr::vector<std::reference_wrapper<Garbage>>;
 
 /**
  * This class implements building-block routines to examine and manipulate
@@ -73,6 +76,13 @@ using GarbageRefVec = std::vector<std::reference_wrapper<Garbage>>;
  * It helps in the transition of the game state by manipulating object tags
  * and behavioral states.
  *
+ * While sweeping over the pit contents, the Logic remembers the candidates
+ * for every later routine (e.g. dissolving garbage, hot blocks) in lists.
+ * The routines therefore must be called in the order of a normal update,
+ * and each Logic object is good for just one update of its pit.
+ * All the lists live in the given memory resource, which is meant to be
+ * a per-tick ScratchArena.
+ *
  * The Director then puts these building-block routines to use every update.
  */
 class Logic
@@ -80,23 +90,32 @@ class Logic
 
 public:
 
-	explicit Logic(Pit& pit) : m_pit(pit) {}
+	explicit Logic(Pit& pit, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+		: m_pit(pit), m_memory(memory),
+		m_dissolvers(memory), m_hots(memory), m_landers(memory), m_touched(memory)
+	{}
 
 	/**
 	 * Mark all objects at the given location and above as potentially falling.
+	 * The pit is swept iteratively, column by column from the bottom up, and
+	 * every object is visited at most once per tick, even if it rests on
+	 * multiple columns.
 	 */
 	void trigger_falls(RowCol rc, bool chaining) const;
 
 	/**
 	 * Look at the pit contents and determine if any of the contents fulfill
 	 * specific criteria.
+	 * This is the last routine of the update. It also clears all tags in
+	 * the same sweep, so that the next update starts without any.
 	 *
 	 * @param[out] chaining whether any block is currently marked as chaining
 	 * @param[out] breaking whether any block is currently being dissolved
 	 * @param[out] full whether any resting physical is up against the pit top
 	 * @param[out] starving whether the bottom+1 row is empty based on scrolling
+	 * @param[out] settled whether all physicals are at rest or in preview
 	 */
-	void examine_pit(bool& chaining, bool& breaking, bool& full, bool& starving) const noexcept;
+	void examine_pit(bool& chaining, bool& breaking, bool& full, bool& starving, bool& settled) noexcept;
 
 	/**
 	 * Classify Physicals whose states are running out.
@@ -108,6 +127,9 @@ public:
 	 * the previous previews become normal blocks at rest.
 	 * In this instant, they are tagged as *hot*.
 	 *
+	 * Garbage which is ready to shrink is tagged with TAG_DISSOLVE and
+	 * remembered in the @ref dissolvers list.
+	 *
 	 * @param[out] dead_physical whether there are new dead physicals
 	 * @param[out] dead_block whether there are new dead blocks
 	 * @param[out] dead_sound whether there are non-fake dead blocks
@@ -115,20 +137,32 @@ public:
 	 * @param[out] new_row whether the bottom of blocks becomes active
 	 */
 	void examine_finish(bool& dead_physical, bool& dead_block, bool& dead_sound,
-	                    bool& chainstop, bool& new_row) const;
+	                    bool& chainstop, bool& new_row);
+
+	/**
+	 * Return the garbage found dissolving by @ref examine_finish.
+	 */
+	const GarbageRefVec& dissolvers() const noexcept { return m_dissolvers; }
 
 	/**
-	 * Shrink or remove expired garbage blocks.
+	 * Shrink or remove expired garbage blocks from the @ref dissolvers list.
 	 * As a result, some physicals may be tagged with TAG_FALL.
 	 */
-	void convert_garbage() const;
+	void convert_garbage();
 
 	/**
 	 * All physicals tagged with TAG_FALL now actually enter the *fall*
 	 * state if possible.
 	 * Successful fallers can not match and therefore have TAG_HOT removed.
+	 * Fallers which come to a halt are tagged with TAG_LAND and remembered
+	 * in the @ref landers list.
 	 */
-	void handle_fallers() const;
+	void handle_fallers();
+
+	/**
+	 * Return the physicals which have landed in @ref handle_fallers.
+	 */
+	const PhysicalRefVec& landers() const noexcept { return m_landers; }
 
 	/**
 	 * All matching blocks and all adjacent garbage bricks enter the *break* state.
@@ -139,15 +173,25 @@ public:
 	 * @param[out] chaining Flag which indicates true if there is a match involving chaining blocks
 	 * @param[out] chainstop Flag which indicates true if chaining blocks have come to rest
 	 */
-	void handle_hots(bool& have_match, int& combo, bool& chaining, bool& chainstop) const;
+	void handle_hots(bool& have_match, int& combo, bool& chaining, bool& chainstop);
 
 private:
 
 	Pit& m_pit;
+	std::pmr::memory_resource* m_memory; //!< storage for temporary containers
+	GarbageRefVec m_dissolvers; //!< garbage tagged with TAG_DISSOLVE
+	BlockRefVec m_hots;         //!< blocks tagged with TAG_HOT
+	PhysicalRefVec m_landers;   //!< physicals tagged with TAG_LAND
+	GarbageRefVec m_touched;    //!< garbage tagged with TAG_TOUCH
+
+	/**
+	 * Tag the block with TAG_HOT and remember it for @ref handle_hots.
+	 */
+	void make_hot(Block& block);
 
 	/**
 	 * Mark the garbage and any other garbage it touches with the TAG_TOUCH tag.
 	 */
-	void touch_garbage(Garbage& garbage) const;
+	void touch_garbage(Garbage& garbage);
 
 };
@@ -3,10 +3,20 @@
 #include "configuration.hpp"
 #include "error.hpp"
 #include "context.hpp"
+#include "sdl_helper.hpp"
+#include "asset.hpp"
+#include "audio.hpp"
+#include <SDL.h>
+#include <cstdio>
 
 namespace
 {
 
+/**
+ * Instantiate the members of the global context based on the configuration.
+ */
+void configure_context(const Configuration& configuration);
+
 /**
  * Cross-platform main function.
  */
@@ -57,6 +67,28 @@ int main(int argc, const char* argv[])
 namespace
 {
 
+void configure_context(const Configuration& configuration)
+{
+	the_context.configuration.reset(new Configuration(configuration));
+	the_context.configuration->apply_runtime();
+
+	const bool is_server_only = LaunchMode::SERVER == the_context.configuration->launch_mode;
+	Uint32 sdl_flags = is_server_only ? SDL_INIT_TIMER | SDL_INIT_EVENTS
+	                                  : SDL_INIT_EVERYTHING;
+
+	the_context.sdl.reset(new Sdl(sdl_flags));
+	the_context.log = create_file_log(the_context.configuration->log_path);
+
+	if(is_server_only) {
+		the_context.assets.reset(new NoAssets);
+		the_context.audio.reset(new NoAudio);
+	}
+	else {
+		the_context.assets.reset(new FileAssets(*the_context.sdl));
+		the_context.audio.reset(new SdlAudio(the_context.sdl->audio()));
+	}
+}
+
 void game_main(int argc, const char* argv[]) noexcept
 {
 	try {
@@ -73,16 +105,22 @@ void game_main(int argc, const char* argv[]) noexcept
 		loop.game_loop();
 	}
 	catch(const std::exception& ex) {
-		if(the_context.log)
+		if(the_context.log) {
 			show_error(ex);
-		else
+		}
+		else {
+			std::fprintf(stderr, "%s\n", ex.what());
 			std::exit(1);
+		}
 	}
 	catch(...) {
-		if(the_context.log)
+		if(the_context.log) {
 			Log::error("Unknown exception occurred.");
-		else
+		}
+		else {
+			std::fprintf(stderr, "Unknown exception occurred.\n");
 			std::exit(1);
+		}
 	}
 }
 
@@ -4,8 +4,15 @@
 #include "game.hpp"
 #include "director.hpp"
 #include "enet_helper.hpp"
+#include "configuration.hpp"
+#include "spsc_queue.hpp"
 #include "error.hpp"
-#include <sstream>
+#include <charconv>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
 #include <cassert>
 
 // These two libraries are dependencies of ENet.
@@ -16,50 +23,138 @@ namespace
 {
 
 const char* msgtype_string[] =
-{"META", "PLAYER", "INPUT", "RETRACT",
+{"META", "PLAYER", "INPUT", "RETRACT", "FINALIZE",
  "SPEED", "SYNC", "CLIENTS", "START", "GAMEEND",
  "BYE", "OFFER", "REMOVE", "JOIN", "LIST", "CHECKIN"};
 
+const char* const WHITESPACE = " \t\n\v\f\r";
+
+/**
+ * Append the decimal digits of the number to the buffer.
+ */
+void append_number(std::string& buffer, int number)
+{
+	char digits[16];
+	const auto result = std::to_chars(std::begin(digits), std::end(digits), number);
+	buffer.append(digits, result.ptr);
+}
+
+/**
+ * Cut the next whitespace-separated token from the front of the text.
+ * Return an empty token if there is none.
+ */
+std::string_view next_token(std::string_view& text)
+{
+	const size_t start = std::min(text.find_first_not_of(WHITESPACE), text.size());
+	const size_t end = std::min(text.find_first_of(WHITESPACE, start), text.size());
+	const std::string_view token = text.substr(start, end - start);
+	text.remove_prefix(end);
+	return token;
+}
+
+/**
+ * Parse the token as a whole decimal number.
+ */
+bool parse_number(std::string_view token, int& number)
+{
+	const auto result = std::from_chars(token.data(), token.data() + token.size(), number);
+	return std::errc{} == result.ec && token.data() + token.size() == result.ptr;
+}
+
 }
 
 std::string Message::to_string() const
+{
+	std::string message_string;
+	encode(message_string);
+	return message_string;
+}
+
+Message Message::from_string(std::string message_string)
+{
+	Message message;
+	message.decode(message_string);
+	return message;
+}
+
+void Message::encode(std::string& buffer) const
 {
 	const size_t type_index = static_cast<size_t>(type);
 	assert(type_index < std::size(msgtype_string));
 
-	std::ostringstream ss;
-	ss << sender << " " << recipient << " "
-	   << msgtype_string[type_index] << " " << data;
-	return ss.str();
+	buffer.clear();
+	append_number(buffer, sender);
+	buffer += ' ';
+	append_number(buffer, recipient);
+	buffer += ' ';
+	buffer += msgtype_string[type_index];
+	buffer += ' ';
+	buffer += data;
 }
 
-Message Message::from_string(std::string message_string)
+void Message::decode(std::string_view bytes)
 {
-	std::istringstream tokenizer(message_string);
+	std::string_view rest = bytes;
 
-	int sender;
-	int recipient;
-	std::string type_string;
-	std::string data;
+	const std::string_view sender_token = next_token(rest);
+	const std::string_view recipient_token = next_token(rest);
+	const std::string_view type_token = next_token(rest);
 
-	tokenizer >> sender >> recipient >> type_string >> std::ws;
-	if(!tokenizer)
-		throwx<GameException>("Invalid Message string: \"%s\"", message_string.c_str());
+	if(!parse_number(sender_token, sender) || !parse_number(recipient_token, recipient) || type_token.empty())
+		throwx<GameException>("Invalid Message string: \"%s\"", std::string{bytes}.c_str());
 
-	std::getline(tokenizer, data);
-
-	const auto type_found = std::find(msgtype_string, std::end(msgtype_string), type_string);
+	const auto type_found = std::find(msgtype_string, std::end(msgtype_string), type_token);
 	const size_t type_index = std::distance(msgtype_string, type_found);
 	if(std::size(msgtype_string) <= type_index)
-		throwx<GameException>("Invalid Message type string: \"%s\"", type_string.c_str());
+		throwx<GameException>("Invalid Message type string: \"%s\"", std::string{type_token}.c_str());
+
+	type = static_cast<MsgType>(type_index);
+
+	// the payload is the rest of the line
+	rest.remove_prefix(std::min(rest.find_first_not_of(WHITESPACE), rest.size()));
+	data.assign(rest.substr(0, rest.find('\n')));
+}
+
+size_t IChannel::poll_into(std::vector<Message>& messages)
+{
+	std::vector<Message> received = poll();
+
+	if(messages.size() < received.size())
+		messages.resize(received.size());
 
-	return Message{sender, recipient, static_cast<MsgType>(type_index), data};
+	std::move(received.begin(), received.end(), messages.begin());
+	return received.size();
+}
+
+void IChannel::wait_until(std::chrono::steady_clock::time_point deadline)
+{
+	std::this_thread::sleep_until(deadline);
 }
 
 
 namespace
 {
 
+/**
+ * Return the element at the index of the received messages, adding it if needed.
+ */
+Message& receive_slot(std::vector<Message>& messages, size_t index)
+{
+	if(messages.size() <= index)
+		messages.resize(index + 1);
+
+	return messages[index];
+}
+
+/**
+ * Return the bytes of the message in the packet, up to the terminating NUL.
+ */
+std::string_view packet_message(const ENetPacket& packet)
+{
+	const std::string_view bytes{reinterpret_cast<const char*>(packet.data), packet.dataLength};
+	return bytes.substr(0, bytes.find('\0'));
+}
+
 /**
  * The @c ServerChannel is a channel implementation that listens for clients
  * on the network. It broadcasts `Message` data structures to all connected
@@ -76,17 +171,28 @@ public:
 
 	virtual void send(Message message) override
 	{
-		Log::trace("Server send message: %s", message.to_string().c_str());
-		PacketPtr packet = ENet::instance().create_packet(message.to_string(), ENET_PACKET_FLAG_RELIABLE);
+		PacketPtr packet = m_packets.create_packet([&message](std::string& data) { message.encode(data); }, ENET_PACKET_FLAG_RELIABLE);
+		Log::trace("Server send message: %s", reinterpret_cast<const char*>(packet->data));
 
+		// all peers share the packet, which is freed after the last one has it
 		enet_host_broadcast(m_host.get(), MESSAGE_CHANNEL, packet.release());
-		enet_host_flush(m_host.get());
+
+		// when batching, the next poll sends the packet along with others
+		if(!runtime_settings().net_batching.load(std::memory_order_relaxed))
+			enet_host_flush(m_host.get());
 	}
 
 	virtual std::vector<Message> poll() override
 	{
-		ENetEvent event;
 		std::vector<Message> messages;
+		messages.resize(poll_into(messages));
+		return messages;
+	}
+
+	virtual size_t poll_into(std::vector<Message>& messages) override
+	{
+		ENetEvent event;
+		size_t count = 0;
 
 		while(enet_host_service(m_host.get(), &event, 0) > 0) {
 			switch(event.type) {
@@ -107,16 +213,20 @@ public:
 
 				case MESSAGE_CHANNEL:
 				{
-					const std::string message_string{reinterpret_cast<char*>(packet->data)};
-					Log::trace("Server got message: %s", message_string.c_str());
-					messages.push_back(Message::from_string(message_string));
+					const std::string_view bytes = packet_message(*packet);
+					Log::trace("Server got message: %.*s", static_cast<int>(bytes.size()), bytes.data());
+					receive_slot(messages, count).decode(bytes);
+					count++;
 				}
 				break;
 
 				default:
+				{
 					// drop packets from unknown channels
-					Log::trace("Server got unknown data: %s", std::string{reinterpret_cast<char*>(packet->data)}.c_str());
-					break;
+					const std::string_view bytes = packet_message(*packet);
+					Log::trace("Server got unknown data: %.*s", static_cast<int>(bytes.size()), bytes.data());
+				}
+				break;
 
 				}
 			}
@@ -135,11 +245,17 @@ public:
 			}
 		}
 
-		return messages;
+		return count;
+	}
+
+	virtual void flush() override
+	{
+		enet_host_flush(m_host.get());
 	}
 
 private:
 
+	PacketPool m_packets; //!< data of sent packets; outlives the host, which frees the packets
 	const HostPtr m_host;  //!< ENetHost object
 
 };
@@ -148,6 +264,9 @@ private:
  * The @c ClientChannel is a channel implementation that connects to a
  * server listening on the network. It sends `Message` data structures
  * to the server and receives messages from it.
+ *
+ * The connection is established without blocking: every poll checks on the
+ * current attempt. Until the connection stands, sent messages are held back.
  */
 class ClientChannel : public IChannel
 {
@@ -155,30 +274,48 @@ class ClientChannel : public IChannel
 public:
 
 	explicit ClientChannel(const char* server_name, enet_uint16 port)
+		: m_server_name(server_name), m_port(port)
 	{
-		std::tie(m_host, m_peer) = ENet::instance().create_client(server_name, port);
-
-		/* Wait up to 5 seconds for the connection attempt to succeed. */
-		ENetEvent event;
-		if(enet_host_service(m_host.get(), &event, CONNECT_TIMEOUT) <= 0 ||
-			event.type != ENET_EVENT_TYPE_CONNECT) {
-			throw ENetException("Connection to server failed.");
-		}
+		connect();
 	}
 
 	virtual void send(Message message) override
 	{
-		Log::trace("Client send message: %s", message.to_string().c_str());
-		PacketPtr packet = ENet::instance().create_packet(message.to_string(), ENET_PACKET_FLAG_RELIABLE);
+		if(Connection::FAILED == m_connection)
+			throw ENetException("Connection to server failed.");
+
+		if(Connection::CONNECTING == m_connection) {
+			m_pending.push_back(std::move(message));
+			return;
+		}
+
+		PacketPtr packet = m_packets.create_packet([&message](std::string& data) { message.encode(data); }, ENET_PACKET_FLAG_RELIABLE);
+		Log::trace("Client send message: %s", reinterpret_cast<const char*>(packet->data));
 
 		enetok(enet_peer_send(m_peer, MESSAGE_CHANNEL, packet.release()));
-		enet_host_flush(m_host.get());
+
+		// when batching, the next poll sends the packet along with others
+		if(!runtime_settings().net_batching.load(std::memory_order_relaxed))
+			enet_host_flush(m_host.get());
 	}
 
 	virtual std::vector<Message> poll() override
 	{
-		ENetEvent event;
 		std::vector<Message> messages;
+		messages.resize(poll_into(messages));
+		return messages;
+	}
+
+	virtual size_t poll_into(std::vector<Message>& messages) override
+	{
+		if(Connection::CONNECTING == m_connection)
+			continue_connect();
+
+		if(Connection::CONNECTED != m_connection)
+			return 0;
+
+		ENetEvent event;
+		size_t count = 0;
 
 		while(enet_host_service(m_host.get(), &event, 0) > 0) {
 			switch(event.type) {
@@ -189,9 +326,10 @@ public:
 
 				enforce(MESSAGE_CHANNEL == event.channelID); // more channels in the future?
 
-				const std::string message_string{reinterpret_cast<char*>(packet->data)};
-				Log::trace("Client got message: %s", message_string.c_str());
-				messages.push_back(Message::from_string(message_string));
+				const std::string_view bytes = packet_message(*packet);
+				Log::trace("Client got message: %.*s", static_cast<int>(bytes.size()), bytes.data());
+				receive_slot(messages, count).decode(bytes);
+				count++;
 			}
 			break;
 
@@ -208,13 +346,456 @@ public:
 			}
 		}
 
+		return count;
+	}
+
+	virtual Connection connection() const override
+	{
+		return m_connection;
+	}
+
+	virtual void flush() override
+	{
+		// messages which wait for the connection cannot go out yet
+		if(Connection::CONNECTED == m_connection)
+			enet_host_flush(m_host.get());
+	}
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	std::string m_server_name;
+	enet_uint16 m_port;
+	PacketPool m_packets; //!< data of sent packets; outlives the host, which frees the packets
+	HostPtr m_host;    //!< ENetHost object, null while waiting to retry
+	ENetPeer* m_peer = nullptr;  //!< ENet peer associated with the server
+	Connection m_connection = Connection::CONNECTING;
+	int m_attempt = 0; //!< number of the current connection attempt, starting at 1
+	Clock::time_point m_deadline; //!< give up on the current attempt at this time
+	Clock::time_point m_retry_time; //!< start the next attempt at this time
+	std::vector<Message> m_pending; //!< messages to send once connected
+
+	/**
+	 * Start a new connection attempt.
+	 */
+	void connect()
+	{
+		m_attempt++;
+		Log::info("Connection attempt %d of %d.", m_attempt, CONNECT_ATTEMPTS);
+
+		std::tie(m_host, m_peer) = ENet::instance().create_client(m_server_name.c_str(), m_port);
+		m_deadline = Clock::now() + std::chrono::milliseconds{CONNECT_TIMEOUT};
+	}
+
+	/**
+	 * Check on the connection attempt without blocking.
+	 * When it fails, schedule the next attempt or give up.
+	 */
+	void continue_connect()
+	{
+		const auto now = Clock::now();
+
+		if(!m_host) {
+			if(now >= m_retry_time)
+				connect();
+
+			return;
+		}
+
+		ENetEvent event;
+
+		while(enet_host_service(m_host.get(), &event, 0) > 0) {
+			if(ENET_EVENT_TYPE_CONNECT == event.type) {
+				Log::info("Connected to server.");
+				m_connection = Connection::CONNECTED;
+
+				for(Message& message : m_pending)
+					send(std::move(message));
+
+				m_pending.clear();
+				return;
+			}
+
+			if(ENET_EVENT_TYPE_DISCONNECT == event.type)
+				m_deadline = now; // refused, no need to wait any longer
+		}
+
+		if(now < m_deadline)
+			return;
+
+		m_host.reset();
+		m_peer = nullptr;
+
+		if(m_attempt >= CONNECT_ATTEMPTS) {
+			Log::error("Connection to server failed.");
+			m_connection = Connection::FAILED;
+			m_pending.clear();
+			return;
+		}
+
+		const std::chrono::milliseconds backoff{CONNECT_BACKOFF << (m_attempt - 1)};
+		Log::info("Connection attempt %d failed. Retry in %d ms.", m_attempt, static_cast<int>(backoff.count()));
+		m_retry_time = now + backoff;
+	}
+
+};
+
+/**
+ * Wakes up a thread which waits for the other side to have something for it.
+ * A ring is not lost when nobody waits at the time; it ends the next wait.
+ */
+class Doorbell
+{
+
+public:
+
+	void ring()
+	{
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_rung = true;
+		}
+
+		m_condition.notify_one();
+	}
+
+	/**
+	 * Wait until the bell rings or the deadline passes.
+	 */
+	void wait_until(std::chrono::steady_clock::time_point deadline)
+	{
+		std::unique_lock<std::mutex> lock{m_mutex};
+		m_condition.wait_until(lock, deadline, [this] { return m_rung; });
+		m_rung = false;
+	}
+
+private:
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_rung = false; //!< true if rung since the last wait
+
+};
+
+/**
+ * The @c ThreadedChannel runs another channel on its own I/O thread.
+ * Only the I/O thread touches the inner channel. It exchanges messages with
+ * the owner's thread through one queue for each direction.
+ */
+class ThreadedChannel : public IChannel
+{
+
+public:
+
+	explicit ThreadedChannel(std::unique_ptr<IChannel> channel)
+		: m_channel(move(channel)),
+		m_outbox(std::make_unique<Queue>()),
+		m_inbox(std::make_unique<Queue>())
+	{
+		enforce(nullptr != m_channel);
+
+		m_connection = m_channel->connection();
+		m_thread = std::thread([this] { io_main(); });
+	}
+
+	/**
+	 * Stop the I/O thread after it has sent all messages from the outbox.
+	 */
+	~ThreadedChannel() noexcept
+	{
+		m_running = false;
+		m_io_bell.ring();
+		m_thread.join();
+	}
+
+	virtual void send(Message message) override
+	{
+		check_io();
+
+		if(Connection::FAILED == m_connection.load(std::memory_order_relaxed))
+			throw ENetException("Connection to server failed.");
+
+		while(!m_outbox->push(message)) {
+			// the I/O thread is behind; it has to catch up eventually
+			m_io_bell.ring();
+			std::this_thread::yield();
+			check_io();
+		}
+
+		m_io_bell.ring();
+	}
+
+	virtual std::vector<Message> poll() override
+	{
+		std::vector<Message> messages;
+		messages.resize(poll_into(messages));
 		return messages;
 	}
 
+	virtual size_t poll_into(std::vector<Message>& messages) override
+	{
+		check_io();
+
+		// the owner's old messages go back to the I/O thread to receive into
+		size_t count = 0;
+		while(m_inbox->pop_exchange(receive_slot(messages, count)))
+			count++;
+
+		return count;
+	}
+
+	virtual Connection connection() const override
+	{
+		return m_connection.load(std::memory_order_relaxed);
+	}
+
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline) override
+	{
+		if(m_inbox->empty())
+			m_poll_bell.wait_until(deadline);
+	}
+
 private:
 
-	HostPtr m_host;    //!< ENetHost object
-	ENetPeer* m_peer;  //!< ENet peer associated with the server
+	using Queue = SpscQueue<Message, NET_QUEUE_CAPACITY>;
+
+	std::unique_ptr<IChannel> m_channel; //!< actual channel, owned by the I/O thread
+	std::unique_ptr<Queue> m_outbox; //!< messages from the owner to the I/O thread
+	std::unique_ptr<Queue> m_inbox; //!< messages from the I/O thread to the owner
+	Doorbell m_io_bell; //!< wakes the I/O thread for sending
+	Doorbell m_poll_bell; //!< wakes the owner for polling
+	std::atomic<Connection> m_connection; //!< latest connection state of the inner channel
+	std::atomic<bool> m_running{true}; //!< cleared to signal the I/O thread to exit
+	std::atomic<bool> m_failed{false}; //!< set when the I/O thread has exited with an error
+	std::exception_ptr m_error; //!< the error from the I/O thread, valid once m_failed is set
+	std::thread m_thread; //!< the I/O thread
+
+	/**
+	 * Main entry point of the I/O thread.
+	 * Pass messages between the queues and the inner channel until told to exit.
+	 * Before it exits, send what the owner has left in the outbox, such as
+	 * the last inputs or GAMEEND.
+	 */
+	void io_main()
+	{
+		set_thread_name("Network I/O");
+
+		std::vector<Message> messages; // received into, and kept for the storage of its elements
+
+		try {
+			while(m_running) {
+				send_outbox();
+
+				const size_t count = m_channel->poll_into(messages);
+				m_connection = m_channel->connection();
+
+				for(size_t i = 0; i < count; i++) {
+					while(!m_inbox->push_exchange(messages[i])) {
+						// the owner is behind; wait for it to catch up, unless it is leaving
+						if(!m_running)
+							break;
+
+						m_poll_bell.ring();
+						std::this_thread::yield();
+					}
+				}
+
+				if(count > 0)
+					m_poll_bell.ring();
+
+				m_io_bell.wait_until(std::chrono::steady_clock::now() + std::chrono::milliseconds{NET_IO_INTERVAL});
+			}
+
+			send_outbox();
+			m_channel->flush();
+		}
+		catch(...) {
+			m_error = std::current_exception();
+			m_failed.store(true, std::memory_order_release);
+			m_poll_bell.ring();
+		}
+	}
+
+	/**
+	 * On the I/O thread, pass all messages from the outbox to the inner channel.
+	 */
+	void send_outbox()
+	{
+		while(std::optional<Message> message = m_outbox->pop()) {
+			// a failed connection cannot deliver what is left
+			if(Connection::FAILED != m_channel->connection())
+				m_channel->send(std::move(*message));
+		}
+	}
+
+	/**
+	 * On the owner's thread, throw the error which ended the I/O thread, if any.
+	 */
+	void check_io() const
+	{
+		if(m_failed.load(std::memory_order_acquire))
+			std::rethrow_exception(m_error);
+	}
+
+};
+
+/**
+ * The @c ConditionedChannel delays, drops, duplicates and reorders the
+ * messages which pass through another channel, as a bad network would.
+ * It holds back every message, in either direction, until its due time.
+ */
+class ConditionedChannel : public IChannel
+{
+
+public:
+
+	explicit ConditionedChannel(std::unique_ptr<IChannel> channel, NetConditions conditions, unsigned seed, NetClock clock)
+		: m_channel(move(channel)), m_conditions(conditions), m_clock(move(clock)), m_random(seed)
+	{
+		enforce(nullptr != m_channel);
+		enforce(m_conditions.latency >= 0 && m_conditions.jitter >= 0);
+		enforce(m_conditions.loss >= 0 && m_conditions.loss < 100); // reliable delivery must succeed eventually
+
+		if(!m_clock)
+			m_clock = [] { return Clock::now(); };
+	}
+
+	virtual void send(Message message) override
+	{
+		const auto now = m_clock();
+		admit(m_outgoing, std::move(message), now);
+		deliver(m_outgoing, now, [this](Message&& due) { m_channel->send(std::move(due)); });
+	}
+
+	virtual std::vector<Message> poll() override
+	{
+		const auto now = m_clock();
+		deliver(m_outgoing, now, [this](Message&& due) { m_channel->send(std::move(due)); });
+
+		for(Message& message : m_channel->poll())
+			admit(m_incoming, std::move(message), now);
+
+		std::vector<Message> messages;
+		deliver(m_incoming, now, [&messages](Message&& due) { messages.push_back(std::move(due)); });
+		return messages;
+	}
+
+	virtual Connection connection() const override
+	{
+		return m_channel->connection();
+	}
+
+	virtual void flush() override
+	{
+		// held-back messages are still on their way
+		m_channel->flush();
+	}
+
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline) override
+	{
+		// a held-back message may become due before anything new arrives
+		if(!m_incoming.heap.empty())
+			deadline = std::min(deadline, m_incoming.heap.front().due);
+
+		m_channel->wait_until(deadline);
+	}
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * A message on its way, with the time when it arrives.
+	 */
+	struct Delayed
+	{
+		Clock::time_point due;
+		long sequence; //!< tie-breaker for equal due times, in order of admission
+		Message message;
+	};
+
+	/**
+	 * Messages in one direction.
+	 */
+	struct Lane
+	{
+		std::vector<Delayed> heap; //!< min-heap by due time
+		long sequence = 0; //!< number of admitted messages
+		Clock::time_point last_due; //!< due time of the latest message in reliable mode
+	};
+
+	static bool later(const Delayed& lhs, const Delayed& rhs) noexcept
+	{
+		return lhs.due > rhs.due || (lhs.due == rhs.due && lhs.sequence > rhs.sequence);
+	}
+
+	std::unique_ptr<IChannel> m_channel;
+	NetConditions m_conditions;
+	NetClock m_clock;
+	std::minstd_rand m_random; //!< source of all random decisions
+	Lane m_outgoing; //!< messages to send to the inner channel
+	Lane m_incoming; //!< messages polled from the inner channel
+
+	/**
+	 * Return true with the given chance in percent.
+	 */
+	bool chance(int percent)
+	{
+		return std::uniform_int_distribution<int>{0, 99}(m_random) < percent;
+	}
+
+	/**
+	 * Decide the fate of the message and put it on its way.
+	 */
+	void admit(Lane& lane, Message message, Clock::time_point now)
+	{
+		if(!m_conditions.reliable && chance(m_conditions.duplication))
+			schedule(lane, message, now);
+
+		schedule(lane, std::move(message), now);
+	}
+
+	void schedule(Lane& lane, Message message, Clock::time_point now)
+	{
+		const int latency = m_conditions.latency;
+		const int jitter = m_conditions.jitter;
+		int delay = latency + std::uniform_int_distribution<int>{0, jitter}(m_random);
+
+		if(chance(m_conditions.reordering))
+			delay += latency + jitter; // later messages overtake this one
+
+		while(chance(m_conditions.loss)) {
+			if(!m_conditions.reliable)
+				return;
+
+			delay += 2 * latency + jitter; // the sender misses the acknowledgement and resends
+		}
+
+		Clock::time_point due = now + std::chrono::milliseconds{delay};
+
+		if(m_conditions.reliable) {
+			due = std::max(due, lane.last_due); // delivery in order
+			lane.last_due = due;
+		}
+
+		lane.heap.push_back(Delayed{due, lane.sequence++, std::move(message)});
+		std::push_heap(lane.heap.begin(), lane.heap.end(), later);
+	}
+
+	/**
+	 * Hand all messages which are due at the given time to the function.
+	 */
+	template<typename Function>
+	void deliver(Lane& lane, Clock::time_point now, Function function)
+	{
+		while(!lane.heap.empty() && lane.heap.front().due <= now) {
+			std::pop_heap(lane.heap.begin(), lane.heap.end(), later);
+			Message message = std::move(lane.heap.back().message);
+			lane.heap.pop_back();
+			function(std::move(message));
+		}
+	}
 
 };
 
@@ -222,12 +803,23 @@ private:
 
 std::unique_ptr<IChannel> make_server_channel(uint16_t port)
 {
-	return std::make_unique<ServerChannel>(port);
+	return make_threaded_channel(std::make_unique<ServerChannel>(port));
 }
 
 std::unique_ptr<IChannel> make_client_channel(const char* server_name, uint16_t port)
 {
-	return std::make_unique<ClientChannel>(server_name, port);
+	return make_threaded_channel(std::make_unique<ClientChannel>(server_name, port));
+}
+
+std::unique_ptr<IChannel> make_threaded_channel(std::unique_ptr<IChannel> channel)
+{
+	return std::make_unique<ThreadedChannel>(move(channel));
+}
+
+std::unique_ptr<IChannel> make_conditioned_channel(std::unique_ptr<IChannel> channel,
+	NetConditions conditions, unsigned seed, NetClock clock)
+{
+	return std::make_unique<ConditionedChannel>(move(channel), conditions, seed, move(clock));
 }
 
 
@@ -255,6 +847,12 @@ void ServerProtocol::retract(long cutoff_time)
 	m_channel->send(std::move(out_msg));
 }
 
+void ServerProtocol::finalize(long horizon)
+{
+	const Message out_msg{0, 0, MsgType::FINALIZE, std::to_string(horizon)};
+	m_channel->send(std::move(out_msg));
+}
+
 void ServerProtocol::speed(int speed)
 {
 	const Message out_msg{0, 0, MsgType::SPEED, std::to_string(speed)};
@@ -275,9 +873,10 @@ void ServerProtocol::gameend(int winner)
 
 void ServerProtocol::poll(IClientMessages& client_messages)
 {
-	const auto messages = m_channel->poll();
+	const size_t count = m_channel->poll_into(m_received);
 
-	for(const auto& message : messages) {
+	for(size_t i = 0; i < count; i++) {
+		const Message& message = m_received[i];
 		switch(message.type) {
 
 		case MsgType::INPUT:
@@ -344,9 +943,10 @@ void ClientProtocol::start()
 
 void ClientProtocol::poll(IServerMessages& server_messages)
 {
-	const auto messages = m_channel->poll();
+	const size_t count = m_channel->poll_into(m_received);
 
-	for(const auto& message : messages) {
+	for(size_t i = 0; i < count; i++) {
+		const Message& message = m_received[i];
 		switch(message.type) {
 
 		case MsgType::INPUT:
@@ -363,6 +963,13 @@ void ClientProtocol::poll(IServerMessages& server_messages)
 		}
 		break;
 
+		case MsgType::FINALIZE:
+		{
+			const long horizon = std::stol(message.data);
+			server_messages.finalize(horizon);
+		}
+		break;
+
 		case MsgType::SPEED:
 		{
 			const int speed = std::stoi(message.data);
@@ -396,14 +1003,71 @@ void ClientProtocol::poll(IServerMessages& server_messages)
 }
 
 
-#include <SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+std::unique_ptr<IGame> make_server_game(uint16_t port)
+{
+	auto server_channel = make_server_channel(port);
+	auto server_protocol = std::make_unique<ServerProtocol>(std::move(server_channel));
+	auto factory = std::make_unique<ServerGameFactory>(*server_protocol);
+	return std::make_unique<ServerGame>(move(factory), move(server_protocol));
+}
+
+void run_server_loop(IGame& game, const std::atomic<bool>& running, ConfigWatcher* watcher)
+{
+	// TODO: this code duplicates code from the GameLoop::game_loop function.
+	//       It should be refactored so that the timed loop is owned/run
+	//       by the active screen and based on a common ILoop.
+
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point t0 = Clock::now(); // start of game time
+	long tick = 0; // current logic tick counter
+
+	// time at which the given logic tick is due
+	const auto tick_time = [&t0](long tick) { return t0 + std::chrono::nanoseconds{std::chrono::seconds{tick}} / TPS; };
+	Clock::time_point next_logic = tick_time(1); // time for next logic update
+
+	// count ticks from 0 when game starts
+	game.after_start([&t0, &tick] { t0 = Clock::now(); tick = 0; });
+
+	while(running)
+	{
+		if(watcher)
+			watcher->poll();
+
+		// process messages as long as logic is up to date
+		const int polls = runtime_settings().polls_per_tick.load(std::memory_order_relaxed);
+		const auto poll_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{1}) / (TPS * polls);
+		Clock::time_point next_poll = Clock::now();
+
+		while(Clock::now() < next_logic) {
+			game.poll();
+
+			// yield CPU if we have the time
+			next_poll = std::min(next_poll + poll_interval, next_logic);
+			// new messages cut the wait short
+			game.wait_until(next_poll);
+		}
+
+		// run logic update, if applicable
+		if(game.switches().ingame && tick > INTRO_TIME) {
+			const long game_time = tick - INTRO_TIME;
+			game.synchronurse(game_time);
+		}
+
+		tick++;
+		next_logic = tick_time(tick + 1);
+	}
+}
 
 ServerThread::ServerThread(std::unique_ptr<IGame> game)
-	: m_game(std::move(game))
+	: m_running(true), m_game(std::move(game))
 {
 	enforce(nullptr != m_game);
 
-	m_exit.test_and_set(); // flag is now known set
 	m_future = std::async([this] { main_loop(); });
 }
 
@@ -413,7 +1077,7 @@ ServerThread::~ServerThread()
 		exit();
 	}
 	catch(const std::exception& ex) {
-		show_error(ex);
+		log_error(ex);
 	}
 	catch(...) {
 		Log::error("Unknown exception occurred.");
@@ -424,7 +1088,7 @@ void ServerThread::exit()
 {
 	if(m_future.valid()) {
 		Log::info("Server thread exit.");
-		m_exit.clear(); // this signals the server to exit
+		m_running = false; // this signals the server to exit
 		m_future.get(); // propagate exceptions from server thread
 	}
 }
@@ -432,43 +1096,5 @@ void ServerThread::exit()
 void ServerThread::main_loop()
 {
 	set_thread_name("Server Thread");
-
-	// TODO: this code duplicates code from the GameLoop::game_loop function.
-	//       It should be refactored so that the timed loop is owned/run
-	//       by the active screen and based on a common ILoop.
-
-	Uint64 t0 = SDL_GetPerformanceCounter(); // start of game time
-	Uint64 freq = SDL_GetPerformanceFrequency();
-	long tick = 0; // current logic tick counter
-	Uint64 next_logic = t0 + freq / TPS; // time for next logic update
-
-	// count ticks from 0 when game starts
-	m_game->after_start([&t0, &tick] { t0 = SDL_GetPerformanceCounter(); tick = 0; });
-
-	while(m_exit.test_and_set())
-	{
-		// process messages as long as logic is up to date
-		Uint64 now = SDL_GetPerformanceCounter();
-		while (now < next_logic) {
-			m_game->poll();
-			now = SDL_GetPerformanceCounter();
-
-			// yield CPU if we have the time
-			if(now < next_logic) {
-				Uint64 wait = (next_logic - now) * 1000L / freq; // in ms
-				assert(wait <= std::numeric_limits<Uint32>::max());
-				SDL_Delay(static_cast<Uint32>(wait));
-				now = SDL_GetPerformanceCounter();
-			}
-		}
-
-		// run logic update, if applicable
-		if(m_game->switches().ingame && tick > INTRO_TIME) {
-			const long game_time = tick - INTRO_TIME;
-			m_game->synchronurse(game_time);
-		}
-
-		tick++;
-		next_logic = t0 + ((Uint64)tick + 1) * freq / TPS;
-	}
+	run_server_loop(*m_game, m_running);
 }
@@ -22,16 +22,20 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <cstdint>
 #include <future>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include "globals.hpp"
 #include "input.hpp"
 #include "error.hpp"
 
 // forward declarations
 class IGame;
+class ConfigWatcher;
 
 // ==================== low-level communication ====================
 
@@ -44,6 +48,7 @@ enum class MsgType
 	PLAYER,  //!< set player number of client
 	INPUT,   //!< player input in the game
 	RETRACT, //!< go back on server-induced block/garbage spawns
+	FINALIZE, //!< game time up to which the inputs are final
 	SPEED,   //!< game playback speed
 	SYNC,    //!< whole game state
 	CLIENTS, //!< request for or sync info about connected clients
@@ -72,6 +77,28 @@ struct Message
 
 	std::string to_string() const;
 	static Message from_string(std::string message_string);
+
+	/**
+	 * Write the wire form of the message into the buffer, replacing its contents.
+	 * A buffer which is kept across calls soon stops allocating.
+	 */
+	void encode(std::string& buffer) const;
+
+	/**
+	 * Read the message from its wire form, replacing the contents of this one.
+	 * The storage of the data is reused.
+	 */
+	void decode(std::string_view bytes);
+};
+
+/**
+ * State of the connection between the local and the remote end of a channel.
+ */
+enum class Connection
+{
+	CONNECTING, //!< still trying to reach the remote end
+	CONNECTED,  //!< messages are exchanged
+	FAILED      //!< gave up on reaching the remote end
 };
 
 /**
@@ -98,20 +125,89 @@ public:
 	 */
 	virtual std::vector<Message> poll() = 0;
 
+	/**
+	 * Check for unhandled messages like @c poll(), but store them at the front
+	 * of the given vector. Existing elements are overwritten, so that their
+	 * storage is reused; the vector grows as needed and never shrinks.
+	 * Channels which decode messages themselves receive them in place.
+	 *
+	 * @return the number of messages received
+	 */
+	virtual size_t poll_into(std::vector<Message>& messages);
+
+	/**
+	 * Return the state of the connection.
+	 * Channels which need not connect anywhere are always connected.
+	 */
+	virtual Connection connection() const { return Connection::CONNECTED; }
+
+	/**
+	 * Put all sent messages on the wire now, even if the channel would
+	 * otherwise batch them until the next poll.
+	 * Channels which do not buffer have nothing to do.
+	 */
+	virtual void flush() {}
+
+	/**
+	 * Wait until new messages may be available to @c poll(), but no longer
+	 * than until the deadline.
+	 * Channels which cannot tell when messages arrive sleep until the deadline.
+	 */
+	virtual void wait_until(std::chrono::steady_clock::time_point deadline);
+
 };
 
 /**
  * Return a Channel for the server side to communicate with clients.
  * It awaits and accepts clients' connections.
+ * The network is serviced on a dedicated I/O thread, see @c make_threaded_channel.
  */
 std::unique_ptr<IChannel> make_server_channel(uint16_t port);
 
 /**
  * Return a Channel for the client side to communicate with the server.
- * Connection errors lead to an exception instead of the creation of the channel.
+ * The channel returns at once and connects in the background on its I/O thread,
+ * see @c make_threaded_channel. Messages sent in the meantime wait for the connection.
+ * Failed attempts are retried after a growing delay, up to CONNECT_ATTEMPTS
+ * times. Then the connection fails and sending throws an @c ENetException.
  */
 std::unique_ptr<IChannel> make_client_channel(const char* server_name, uint16_t port);
 
+/**
+ * Return a Channel which services the given channel on a dedicated I/O thread.
+ * Sent messages travel to the I/O thread, and received messages come back,
+ * through lock-free queues. Thus neither sending nor polling waits for the
+ * network, and a slow caller does not delay the network traffic.
+ * The I/O thread ends the @c wait_until of the caller when messages arrive.
+ * Errors on the I/O thread are thrown from the next call to @c send or @c poll.
+ *
+ * The given channel must not be used by anyone else afterwards.
+ */
+std::unique_ptr<IChannel> make_threaded_channel(std::unique_ptr<IChannel> channel);
+
+/**
+ * Source of the current time for channels which simulate network conditions.
+ * Simulations which do not run in real time can supply their own clock.
+ */
+using NetClock = std::function<std::chrono::steady_clock::time_point()>;
+
+/**
+ * Return a Channel which imposes the given network conditions on the messages
+ * that pass through the given channel in both directions.
+ * To simulate one link between two end points, wrap only one of them.
+ *
+ * Delayed messages are delivered when the channel is polled or sent to after
+ * their due time. In reliable mode, the conditions only affect the timing,
+ * like with ENet's reliable packets: lost messages are resent after a round
+ * trip, later messages wait for earlier ones and duplicates are discarded.
+ * Otherwise, messages really go missing, arrive twice or out of order.
+ *
+ * @param seed initializes the random decisions, for reproducible simulations
+ * @param clock supplies the time, by default the steady clock
+ */
+std::unique_ptr<IChannel> make_conditioned_channel(std::unique_ptr<IChannel> channel,
+	NetConditions conditions, unsigned seed, NetClock clock = {});
+
 // ==================== communication protocols ====================
 
 /**
@@ -127,6 +223,7 @@ public:
 	virtual void meta(GameMeta meta) = 0;
 	virtual void input(Input input) = 0;
 	virtual void retract(long cutoff_time) = 0;
+	virtual void finalize(long horizon) = 0;
 	virtual void speed(int speed) = 0;
 	virtual void start() = 0;
 	virtual void gameend(int winner) = 0;
@@ -168,6 +265,7 @@ public:
 	virtual void meta(GameMeta meta) override;
 	virtual void input(Input input) override;
 	virtual void retract(long cutoff_time) override;
+	virtual void finalize(long horizon) override;
 	virtual void speed(int speed) override;
 	virtual void start() override;
 	virtual void gameend(int winner) override;
@@ -179,9 +277,16 @@ public:
 	 */
 	void poll(IClientMessages& client_messages);
 
+	/**
+	 * Wait until client messages may be available to @c poll(), but no longer
+	 * than until the deadline.
+	 */
+	void wait_until(std::chrono::steady_clock::time_point deadline) { m_channel->wait_until(deadline); }
+
 private:
 
 	std::unique_ptr<IChannel> m_channel;
+	std::vector<Message> m_received; //!< storage for polled messages, reused by every poll
 
 };
 
@@ -212,14 +317,40 @@ public:
 	 */
 	void poll(IServerMessages& server_messages);
 
+	/**
+	 * Wait until server messages may be available to @c poll(), but no longer
+	 * than until the deadline.
+	 */
+	void wait_until(std::chrono::steady_clock::time_point deadline) { m_channel->wait_until(deadline); }
+
+	/**
+	 * Return the state of the connection to the server.
+	 */
+	Connection connection() const { return m_channel->connection(); }
+
 private:
 
 	std::unique_ptr<IChannel> m_channel;
+	std::vector<Message> m_received; //!< storage for polled messages, reused by every poll
 
 };
 
 // ==================== integration with game logic ====================
 
+/**
+ * Create the game object for a server which accepts clients on the given port.
+ */
+std::unique_ptr<IGame> make_server_game(uint16_t port);
+
+/**
+ * Run the timed main loop of a game server on the calling thread.
+ * It processes messages and game logic until the @c running flag is cleared,
+ * which is safe to do from another thread or from a signal handler.
+ * Between ticks, it polls for messages as often as the run-time settings say.
+ * If given, the loop also checks the @c watcher for configuration changes.
+ */
+void run_server_loop(IGame& game, const std::atomic<bool>& running, ConfigWatcher* watcher = nullptr);
+
 /**
  * Runs a server in a thread until the object is destroyed.
  */
@@ -248,13 +379,13 @@ public:
 
 private:
 
-	std::atomic_flag m_exit;
+	std::atomic<bool> m_running; //!< cleared to signal the server to exit
 	std::future<void> m_future;
 	std::unique_ptr<IGame> m_game;
 
 	/**
 	 * Main entry point of the thread.
-	 * It will periodically check the @c m_exit flag while handling requests.
+	 * It will periodically check the @c m_running flag while handling requests.
 	 */
 	void main_loop();
 
@@ -12,6 +12,7 @@
 #include <cctype>
 #include <cstring>
 #include <cassert>
+#include <atomic>
 
 ReplayRecord ReplayRecord::make_start() noexcept
 {
@@ -40,6 +41,7 @@ ReplayRecord ReplayRecord::make_input(Input input) noexcept
 Journal::Journal(GameMeta meta, GameState state0)
 : m_meta(meta), m_checkpoint({state0}), m_earliest_undiscovered(NO_UNDISCOVERED)
 {
+	m_recent.reserve(RECENT_CHECKPOINTS);
 }
 
 namespace
@@ -60,6 +62,31 @@ struct CompareInputTime
 	}
 };
 
+/**
+ * Helper for finding the place of a new input in the journal's sorted inputs.
+ * Within the same tick, inputs are sorted by their source.
+ */
+struct CompareInputOrder
+{
+	bool operator()(const Input& new_input, const Input& input) noexcept
+	{
+		const long new_time = new_input.game_time();
+		const long time = input.game_time();
+		return new_time < time || (new_time == time && new_input.source() < input.source());
+	}
+};
+
+}
+
+template<typename Pred>
+void Journal::prune_checkpoints(Pred is_obsolete)
+{
+	auto obs_it = std::remove_if(m_checkpoint.begin(), m_checkpoint.end(), is_obsolete);
+	m_checkpoint.erase(obs_it, m_checkpoint.end());
+
+	auto recent_obs_it = std::remove_if(m_recent.begin(), m_recent.end(),
+		[&is_obsolete](const auto& s) { return is_obsolete(*s); });
+	m_recent.erase(recent_obs_it, m_recent.end());
 }
 
 InputSpan Journal::get_inputs(long game_time) noexcept
@@ -74,23 +101,26 @@ void Journal::add_input(Input input)
 	Log::trace("Journal add_input: %s.", std::string(input).c_str());
 
 	const long itime = input.game_time();
-	enforce(itime > 0);
+	enforce(itime > m_horizon);
 
 	if(m_earliest_undiscovered > itime)
 		m_earliest_undiscovered = itime;
 
-	// ordered insert of the input into the record
-	const auto after = upper_bound(m_inputs.begin(), m_inputs.end(), itime, CompareInputTime{});
-	m_inputs.insert(after, input);
+	// Ordered insert of the input into the record.
+	// Within one tick, the arbiter comes first, then each player in turn, while
+	// the inputs from one source stay in the order of arrival. This way, all
+	// peers agree on the order of inputs, even if some of them arrive late.
+	const auto after = upper_bound(m_inputs.begin(), m_inputs.end(), input, CompareInputOrder{});
+	m_inputs.insert(after, std::move(input));
 
 	// prune checkpoints to maintain integrity
-	auto is_obsolete = [itime](const GameState& s) { return s.game_time() >= itime; };
-	auto obs_it = std::remove_if(m_checkpoint.begin(), m_checkpoint.end(), is_obsolete);
-	m_checkpoint.erase(obs_it, m_checkpoint.end());
+	prune_checkpoints([itime](const GameState& s) { return s.game_time() >= itime; });
 }
 
 void Journal::retract(long time)
 {
+	enforce(time >= m_horizon);
+
 	struct IsRetractable
 	{
 		bool operator()(const PlayerInput& ) { return false; }
@@ -102,10 +132,27 @@ void Journal::retract(long time)
 	auto new_end = std::remove_if(m_inputs.begin(), m_inputs.end(), is_retractable);
 	m_inputs.erase(new_end, m_inputs.end());
 
+	// the retracted inputs may come back differently
+	prune_checkpoints([time](const GameState& s) { return s.game_time() > time; });
+
 	// we have "undiscovered" the potential inputs that we might want to generate again.
 	m_earliest_undiscovered = time + 1;
 }
 
+void Journal::finalize(long time)
+{
+	enforce(time >= m_horizon);
+	m_horizon = time;
+
+	// the latest checkpoint at or before the horizon is the earliest that a rollback needs
+	auto is_final = [time](const GameState& s) { return s.game_time() <= time; };
+	const auto base = std::find_if(m_checkpoint.rbegin(), m_checkpoint.rend(), is_final);
+	assert(base != m_checkpoint.rend());
+
+	const long base_time = base->game_time();
+	prune_checkpoints([base_time](const GameState& s) { return s.game_time() < base_time; });
+}
+
 void Journal::set_winner(int winner) noexcept
 {
 	enforce(winner == NOONE || (winner >= 0 && winner < m_meta.players));
@@ -123,15 +170,58 @@ void Journal::add_checkpoint(GameState&& checkpoint)
 	m_checkpoint.emplace_back(checkpoint);
 }
 
+std::shared_ptr<const GameState> Journal::add_recent_checkpoint(const GameState& checkpoint)
+{
+	const long time = checkpoint.game_time();
+	std::shared_ptr<GameState> slot; // storage which the journal no longer needs
+
+	// a re-simulated tick supersedes its previous version
+	while(!m_recent.empty() && m_recent.back()->game_time() >= time) {
+		slot = std::move(m_recent.back());
+		m_recent.pop_back();
+	}
+
+	if(!slot && m_recent.size() >= RECENT_CHECKPOINTS) {
+		slot = std::move(m_recent.front());
+		m_recent.erase(m_recent.begin());
+	}
+
+	// Readers of a shared checkpoint may still be looking at it on another thread.
+	// If we hold the only reference, nobody can obtain another one.
+	if(slot && 1 == slot.use_count()) {
+		std::atomic_thread_fence(std::memory_order_acquire); // see the readers' release
+		*slot = checkpoint;
+	}
+	else {
+		slot = std::make_shared<GameState>(checkpoint);
+	}
+
+	m_recent.push_back(slot);
+	return slot;
+}
+
+long Journal::last_checkpoint_time() const noexcept
+{
+	assert(m_checkpoint.size() > 0);
+	return m_checkpoint.back().game_time();
+}
+
 const GameState& Journal::checkpoint_before(long game_time) const
 {
 	enforce(game_time > 0);
 
-	const auto end = m_checkpoint.rend();
-	const auto it = std::find_if(m_checkpoint.rbegin(), end,
-		[game_time](const GameState& s) { return s.game_time() < game_time; });
+	auto is_before = [game_time](const GameState& s) { return s.game_time() < game_time; };
 
+	const auto end = m_checkpoint.rend();
+	const auto it = std::find_if(m_checkpoint.rbegin(), end, is_before);
 	assert(it != end);
+
+	// a recent checkpoint is usually closer
+	const auto recent_it = std::find_if(m_recent.rbegin(), m_recent.rend(),
+		[&is_before](const auto& s) { return is_before(*s); });
+	if(m_recent.rend() != recent_it && (*recent_it)->game_time() > it->game_time())
+		return **recent_it;
+
 	return *it;
 }
 
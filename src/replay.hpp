@@ -13,6 +13,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include "globals.hpp"
@@ -63,7 +64,7 @@ public:
 	GameMeta meta() const noexcept { return m_meta; }
 
 	//! Time value of earliest undiscovered input if there are no new inputs.
-	static const long NO_UNDISCOVERED = std::numeric_limits<long>::max();
+	static constexpr long NO_UNDISCOVERED = std::numeric_limits<long>::max();
 
 	/**
 	 * Return the earliest time at which an input happens that has not yet been discovered
@@ -92,16 +93,33 @@ public:
 
 	/**
 	 * Add an input into the queue and mark it as undiscovered.
+	 * Inputs for the same time are ordered by their source.
 	 * All checkpoints made at or after the time of the input become obsolete.
+	 * The input must come after the horizon.
 	 */
 	void add_input(Input input);
 
 	/**
 	 * Remove all retractable (non-player) inputs after the given @c time from
 	 * memory.
+	 * All checkpoints made after the given @c time become obsolete.
+	 * The time must not be before the horizon.
 	 */
 	void retract(long time);
 
+	/**
+	 * Declare the game final up to the given @c time.
+	 * No more inputs or retractions may change it. Rollbacks therefore never
+	 * reach back further than the latest sparse checkpoint at or before the
+	 * horizon, and all earlier checkpoints are released.
+	 */
+	void finalize(long time);
+
+	/**
+	 * Return the time up to which the game is final.
+	 */
+	long horizon() const noexcept { return m_horizon; }
+
 	/**
 	 * Update the winner in the meta information.
 	 */
@@ -109,11 +127,29 @@ public:
 
 	/**
 	 * Enter a checkpoint into the journal.
+	 * These checkpoints are sparse, but kept until the horizon passes them.
 	 */
 	void add_checkpoint(GameState&& checkpoint);
 
 	/**
-	 * Return the latest checkpoint state before the given time.
+	 * Enter a short-lived checkpoint into the journal.
+	 * Only the latest @c RECENT_CHECKPOINTS of these are kept, which allows
+	 * late inputs to roll back just a few ticks instead of to the last
+	 * sparse checkpoint.
+	 * Recent checkpoints at or after the time of the new one are replaced.
+	 * The copy goes into the storage of the replaced or expired checkpoint,
+	 * unless someone else still holds on to that one.
+	 * @return the journal's copy of the checkpoint, which readers may share
+	 */
+	std::shared_ptr<const GameState> add_recent_checkpoint(const GameState& checkpoint);
+
+	/**
+	 * Return the time of the latest sparse checkpoint.
+	 */
+	long last_checkpoint_time() const noexcept;
+
+	/**
+	 * Return the latest checkpoint state, sparse or recent, before the given time.
 	 */
 	const GameState& checkpoint_before(long game_time) const;
 
@@ -122,7 +158,15 @@ private:
 	GameMeta m_meta;
 	Inputs m_inputs; //!< all inputs ordered by time
 	long m_earliest_undiscovered;
+	long m_horizon = 0; //!< inputs up to this time are final
 	std::vector<GameState> m_checkpoint; //!< checkpoints ordered by time
+	std::vector<std::shared_ptr<GameState>> m_recent; //!< most recent checkpoints ordered by time
+
+	/**
+	 * Remove all checkpoints, sparse or recent, for which the predicate holds.
+	 */
+	template<typename Pred>
+	void prune_checkpoints(Pred is_obsolete);
 
 };
 
@@ -0,0 +1,51 @@
+/**
+ * scratch.hpp
+ * Memory for short-lived temporary containers.
+ */
+
+#pragma once
+
+#include <memory_resource>
+#include <memory>
+#include <cstddef>
+
+/**
+ * The ScratchArena hands out memory for temporary containers which live no
+ * longer than one well-defined unit of work, such as one tick of game logic.
+ *
+ * Memory comes from a buffer of fixed capacity and is never freed
+ * individually. Only if the buffer runs out, the arena falls back to the heap.
+ * The owner calls @ref release at a point where none of the containers exist
+ * anymore to make the whole buffer available again.
+ * This way, the steady-state game logic does not allocate on the heap at all.
+ */
+class ScratchArena
+{
+
+public:
+
+	explicit ScratchArena(std::size_t capacity)
+		: m_buffer(std::make_unique<std::byte[]>(capacity)),
+		m_resource(m_buffer.get(), capacity)
+	{}
+
+	ScratchArena(const ScratchArena&) = delete;
+	ScratchArena& operator=(const ScratchArena&) = delete;
+
+	/**
+	 * Return the memory resource for use with @c std::pmr containers.
+	 */
+	std::pmr::memory_resource* resource() noexcept { return &m_resource; }
+
+	/**
+	 * Reclaim all memory handed out so far.
+	 * All containers using the arena must be gone before this call.
+	 */
+	void release() noexcept { m_resource.release(); }
+
+private:
+
+	std::unique_ptr<std::byte[]> m_buffer; //!< fixed-capacity storage
+	std::pmr::monotonic_buffer_resource m_resource; //!< allocation strategy on the buffer
+
+};
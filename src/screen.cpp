@@ -18,8 +18,9 @@ namespace
 
 /**
  * Create a new thread for running the server game.
+ * If given, the server game keeps the feed up to date for a host player.
  */
-std::unique_ptr<ServerThread> create_server_thread(int port);
+std::unique_ptr<ServerThread> create_server_thread(int port, std::shared_ptr<GameFeed> feed = nullptr);
 
 /**
  * Create and return the game object for a local game.
@@ -31,6 +32,17 @@ std::shared_ptr<LocalGame> create_local_game();
  */
 std::shared_ptr<ClientGame> create_client_game(const char* server_url, int port);
 
+/**
+ * Create and return the game object for the player who hosts the server.
+ * It shows the server game from the feed instead of simulating it again.
+ */
+std::shared_ptr<HostGame> create_host_game(int port, std::shared_ptr<GameFeed> feed);
+
+/**
+ * Impose the simulated network conditions from the configuration, if any, on the channel.
+ */
+std::unique_ptr<IChannel> condition_channel(std::unique_ptr<IChannel> channel);
+
 }
 
 IScreen::IScreen(IDraw& draw) : m_draw(&draw) {}
@@ -72,9 +84,13 @@ IScreen* ScreenFactory::create_default()
 	}
 
 	// Set up server thread if applicable
+	std::shared_ptr<GameFeed> feed;
+	if(LaunchMode::WITH_SERVER == configuration.launch_mode)
+		feed = std::make_shared<GameFeed>();
+
 	if(LaunchMode::SERVER == configuration.launch_mode ||
 		LaunchMode::WITH_SERVER == configuration.launch_mode) {
-		m_server = create_server_thread(configuration.port);
+		m_server = create_server_thread(configuration.port, feed);
 	}
 
 	// Another straightforward setup: server (game object is in the server thread)
@@ -101,9 +117,7 @@ IScreen* ScreenFactory::create_default()
 			break;
 
 		case LaunchMode::WITH_SERVER:
-			m_game = create_client_game(
-				"localhost",
-				configuration.port);
+			m_game = create_host_game(configuration.port, feed);
 			break;
 
 		default:
@@ -140,10 +154,11 @@ IScreen* ScreenFactory::create_next(IScreen& predecessor)
 			break;
 
 		case MenuScreen::Result::PLAY_HOST:
-			m_server = create_server_thread(configuration.port);
-			m_game = create_client_game(
-				"localhost",
-				configuration.port);
+		{
+			auto feed = std::make_shared<GameFeed>();
+			m_server = create_server_thread(configuration.port, feed);
+			m_game = create_host_game(configuration.port, feed);
+		}
 			break;
 
 		case MenuScreen::Result::PLAY_CLIENT:
@@ -166,8 +181,8 @@ IScreen* ScreenFactory::create_next(IScreen& predecessor)
 		if(PregameScreen::Result::PLAY == pregame->result()) {
 			std::unique_ptr<Agent> agent;
 			if(const auto ai_player = configuration.ai_player) {
-				const int delay = std::array<int, 3>{15, 8, 2}.at(configuration.ai_level);
-				agent.reset(new Agent(m_game->state(), ai_player.value(), delay));
+				const int delay = configuration.ai_delay.value_or(std::array<int, 3>{15, 8, 2}.at(configuration.ai_level));
+				agent.reset(new Agent(m_game->snapshot(), ai_player.value(), delay));
 			}
 			m_game_screen = std::make_unique<GameScreen>(*m_draw, m_game, m_rules, m_server.get(), move(agent));
 			m_game_screen->set_autorecord(configuration.autorecord && !configuration.replay_path.has_value());
@@ -459,12 +474,13 @@ void PregameScreen::update()
 void PregameScreen::input(ControllerAction cinput)
 {
 	if(ButtonAction::DOWN == cinput.action) {
-		if(Button::A == cinput.button) {
+		if(Button::A == cinput.button && Connection::CONNECTED == m_game->connection()) {
 			// this calls my after_start handler, which will set m_done = true.
 			m_game->game_reset(2, m_rules, false);
 			m_game->game_start();
 		} else
 		if(Button::QUIT == cinput.button) {
+			// also cancels connecting to the server
 			m_result = Result::QUIT;
 			m_done = true;
 		}
@@ -474,8 +490,41 @@ void PregameScreen::input(ControllerAction cinput)
 void PregameScreen::draw_impl(float dt)
 {
 	m_draw->gfx(0, 0, Gfx::TITLE);
+
+	const Connection connection = m_game->connection();
+	if(Connection::CONNECTED != connection)
+		draw_connection(connection);
 }
 
+void PregameScreen::draw_connection(Connection connection)
+{
+	if(!m_font)
+		m_font = std::make_unique<BitmapFont>(*the_context.sdl, the_context.assets->charset(), STATUS_OUTLINE_COLOR, STATUS_FILL_COLOR);
+
+	const int x = 60;
+	const int y = CANVAS_H - 4 * BITMAP_FONT_LINEHEIGHT;
+
+	if(Connection::CONNECTING == connection) {
+		m_draw->text_fixed(x, y, *m_font, "CONNECTING");
+
+		// progress indicator: a bar sweeping back and forth once per second
+		const int BAR_W = 200;
+		const int BLOCK_W = 40;
+		const int phase = static_cast<int>(m_time % TPS);
+		const int offset = (phase < TPS / 2 ? phase : TPS - phase) * (BAR_W - BLOCK_W) * 2 / TPS;
+		m_draw->rect({x, y + BITMAP_FONT_LINEHEIGHT + 4, BAR_W, 8}, {0, 0, 0, 128});
+		m_draw->rect({x + offset, y + BITMAP_FONT_LINEHEIGHT + 4, BLOCK_W, 8}, STATUS_FILL_COLOR);
+	}
+	else {
+		m_draw->text_fixed(x, y, *m_font, "CONNECTION FAILED");
+	}
+
+	m_draw->text_fixed(x, y + 2 * BITMAP_FONT_LINEHEIGHT, *m_font, "ESC: BACK");
+}
+
+const wrap::Color PregameScreen::STATUS_OUTLINE_COLOR{ 111, 31, 148, 255 };
+const wrap::Color PregameScreen::STATUS_FILL_COLOR{ 108, 200, 200, 255 };
+
 
 GameScreen::GameScreen(
 	IDraw& draw,
@@ -488,7 +537,7 @@ GameScreen::GameScreen(
 	m_phase(Phase::INTRO),
 	m_time(0),
 	m_done(false),
-	m_stage(new Stage(game->state(), *m_draw)),
+	m_stage(new Stage(game->snapshot(), *m_draw)),
 	m_game(move(game)),
 	m_rules(rules),
 	m_server(server),
@@ -504,7 +553,7 @@ GameScreen::GameScreen(
 	m_game->before_reset([this] {
 		// preserve the replay before it is gone
 		autorecord_replay();
-		m_stage->set_state(nullptr);
+		m_stage->set_snapshot(nullptr);
 		m_done = true;
 		m_game->before_reset(nullptr); // don't call this handler twice
 	});
@@ -561,7 +610,9 @@ void GameScreen::input(ControllerAction cinput)
 			std::optional<PlayerInput> oinput = controller_to_input(cinput);
 			if(oinput.has_value()) {
 				// TODO: network should assign the actual input time
-				oinput->game_time = m_time + 1; // input applies to next frame
+				// Input applies to the next tick, which is the earliest one not yet simulated,
+				// plus the input delay to hide the network round trip.
+				oinput->game_time = m_time + 1 + m_game->input_delay();
 				m_game->game_input(Input{oinput.value()});
 			}
 		}
@@ -697,6 +748,12 @@ void GameScreen::update_play()
 
 	// query inputs from agent, if applicable
 	if(m_agent) {
+		// the delay can be tuned while the game runs
+		if(const int delay = runtime_settings().ai_delay.load(std::memory_order_relaxed); delay >= 0)
+			m_agent->set_delay(delay);
+
+		m_agent->set_input_delay(m_game->input_delay());
+
 		for(const PlayerInput pi : m_agent->move()) {
 			m_game->game_input(Input{ pi });
 		}
@@ -779,13 +836,11 @@ void TransitionScreen::draw_impl(float dt)
 namespace
 {
 
-std::unique_ptr<ServerThread> create_server_thread(int port)
+std::unique_ptr<ServerThread> create_server_thread(int port, std::shared_ptr<GameFeed> feed)
 {
-	auto server_channel = make_server_channel(port);
-	auto server_protocol = std::make_unique<ServerProtocol>(std::move(server_channel));
-	auto factory = std::make_unique<ServerGameFactory>(*server_protocol);
-	auto sever_game = std::make_unique<ServerGame>(move(factory), move(server_protocol));
-	return std::make_unique<ServerThread>(std::move(sever_game));
+	std::unique_ptr<IGame> game = make_server_game(port);
+	game->set_feed(move(feed));
+	return std::make_unique<ServerThread>(move(game));
 }
 
 std::shared_ptr<LocalGame> create_local_game()
@@ -796,10 +851,31 @@ std::shared_ptr<LocalGame> create_local_game()
 
 std::shared_ptr<ClientGame> create_client_game(const char* server_url, const int port)
 {
-	auto client_channel = make_client_channel(server_url, port);
+	auto client_channel = condition_channel(make_client_channel(server_url, port));
 	auto client_protocol = std::make_unique<ClientProtocol>(std::move(client_channel));
 	auto factory = std::make_unique<ClientGameFactory>();
 	return std::make_shared<ClientGame>(move(factory), move(client_protocol));
 }
 
+std::shared_ptr<HostGame> create_host_game(const int port, std::shared_ptr<GameFeed> feed)
+{
+	auto client_channel = condition_channel(make_client_channel("localhost", port));
+	auto client_protocol = std::make_unique<ClientProtocol>(std::move(client_channel));
+	auto factory = std::make_unique<ClientGameFactory>();
+	return std::make_shared<HostGame>(move(factory), move(client_protocol), move(feed));
+}
+
+std::unique_ptr<IChannel> condition_channel(std::unique_ptr<IChannel> channel)
+{
+	const NetConditions& conditions = the_context.configuration->netsim;
+	if(!conditions.active())
+		return channel;
+
+	Log::info("Simulate network conditions: latency=%d, jitter=%d, loss=%d%%, duplication=%d%%, reordering=%d%%.",
+		conditions.latency, conditions.jitter, conditions.loss, conditions.duplication, conditions.reordering);
+
+	static std::random_device rdev;
+	return make_conditioned_channel(move(channel), conditions, rdev());
+}
+
 }
@@ -202,6 +202,9 @@ protected:
 
 private:
 
+	static const wrap::Color STATUS_OUTLINE_COLOR;
+	static const wrap::Color STATUS_FILL_COLOR;
+
 	long m_time; //!< starts at 0 and increases with update()
 	bool m_done; //!< true if this screen has reached its end
 	Result m_result; //!< valid only when m_done
@@ -209,6 +212,12 @@ private:
 	IDraw* m_draw; //!< Interface for drawing the screen
 	std::shared_ptr<IGame> m_game; //!< Game object
 	Rules m_rules; //!< game creation parameters
+	std::unique_ptr<BitmapFont> m_font; //!< font for the connection status, created on demand
+
+	/**
+	 * Show that the game is still connecting to the server, or has failed to.
+	 */
+	void draw_connection(Connection connection);
 
 };
 
@@ -1,5 +1,8 @@
 #include "sdl_helper.hpp"
 #include "error.hpp"
+#include "context.hpp"
+#include "asset.hpp"
+#include "text.hpp"
 #include <cassert>
 #include <cstring>
 #include <SDL.h>
@@ -24,6 +27,95 @@ Uint32 getpixel(SDL_Surface& surface, int x, int y) noexcept;
  */
 void setpixel(SDL_Surface& surface, int x, int y, Uint32 data) noexcept;
 
+/**
+ * Replace spaces with line breaks after at least the given number of characters in each line.
+ */
+void auto_linebreaks(std::string& str, int n);
+
+}
+
+
+SdlException::SdlException(const char* what)
+: GameExceptionCloning("%s", what ? what : SDL_GetError())
+{}
+
+void sdlok(int result)
+{
+	if(0 != result)
+		throwx<SdlException>();
+}
+
+void sdlok(void* pointer)
+{
+	if(!pointer)
+		throwx<SdlException>();
+}
+
+void imgok(void* pointer)
+{
+	if(!pointer)
+		throwx<SdlException>(IMG_GetError());
+}
+
+void ttfok(void* pointer)
+{
+	if(!pointer)
+		throwx<SdlException>(TTF_GetError());
+}
+
+void show_error(const std::exception& exception) noexcept
+{
+	std::string what;
+
+	// put the error message in the log file
+	if(const GameException* game_ex = dynamic_cast<const GameException*>(&exception)) {
+		what = string_format("%s: %s", game_ex->class_name(), game_ex->what());
+	} else {
+		what = string_format("%s", exception.what());
+	}
+
+	Log::error("%s", what.c_str());
+
+	// display to the user, if we have SDL available.
+	Uint32 init = SDL_WasInit(SDL_INIT_EVERYTHING);
+
+	if(init & SDL_INIT_VIDEO) {
+		SDL_Renderer* renderer = &the_context.sdl->renderer();
+		SDL_Event event;
+		if(0 == SDL_WaitEvent(&event)) return;
+
+		auto_linebreaks(what, 40);
+		TtfText what_text(*the_context.sdl, the_context.assets->ttf_font(), what.c_str());
+
+		do {
+			// rects
+			SDL_Rect outer_rect{30, 30, CANVAS_W - 60, CANVAS_H - 60};
+			SDL_Rect inner_rect{60, 60, CANVAS_W - 120, CANVAS_H - 120};
+			if(0 != SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE)) break;
+			if(0 != SDL_RenderFillRect(renderer, &outer_rect)) break;
+			if(0 != SDL_SetRenderDrawColor(renderer, 255, 0, 0, SDL_ALPHA_OPAQUE)) break;
+			if(0 != SDL_RenderFillRect(renderer, &inner_rect)) break;
+
+			// text
+			SDL_Texture& tex = what_text.texture();
+			Uint32 format;
+			int access;
+			int w;
+			int h;
+			sdlok(SDL_QueryTexture(&tex, &format, &access, &w, &h));
+			const SDL_Rect dest_rect{ 70, CANVAS_H/2 - 40, w, h };
+			sdlok(SDL_RenderCopy(renderer, &tex, NULL, &dest_rect));
+
+			// finish
+			SDL_RenderPresent(renderer);
+
+			if(SDL_QUIT == event.type ||
+				(SDL_KEYDOWN == event.type &&
+				(SDLK_ESCAPE == event.key.keysym.sym || SDLK_RETURN == event.key.keysym.sym))) {
+				break;
+			}
+		} while(SDL_WaitEvent(&event));
+	}
 }
 
 
@@ -162,11 +254,14 @@ SdlSoundPlayer& SdlSoundPlayer::operator=(SdlSoundPlayer&&) noexcept = default;
 void SdlSoundPlayer::play(const Sound& sound) { m_impl->play(sound); }
 
 
-Sdl::Sdl(uint32_t flags)
+Sdl::Sdl(uint32_t flags, bool headless)
 {
 	assert(!SDL_WasInit(0));
 	assert(!TTF_WasInit());
 
+	if(headless)
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+
 	// basic library setup
 	sdlok(SDL_Init(flags));
 
@@ -186,10 +281,12 @@ Sdl::Sdl(uint32_t flags)
 
 	// graphics: window & renderer
 	if(flags & SDL_INIT_VIDEO) {
-		m_window.reset(SDL_CreateWindow(APP_NAME, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, CANVAS_W, CANVAS_H, 0));
+		const Uint32 window_flags = headless ? SDL_WINDOW_HIDDEN : 0;
+		m_window.reset(SDL_CreateWindow(APP_NAME, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, CANVAS_W, CANVAS_H, window_flags));
 		sdlok(m_window.get());
 
-		m_renderer.reset(SDL_CreateRenderer(m_window.get(), -1, SDL_RENDERER_TARGETTEXTURE));
+		const Uint32 renderer_flags = headless ? SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE : SDL_RENDERER_TARGETTEXTURE;
+		m_renderer.reset(SDL_CreateRenderer(m_window.get(), -1, renderer_flags));
 		sdlok(m_renderer.get());
 
 		// The renderer must declare the capabilities to render stuff offscreen onto target textures.
@@ -469,4 +566,15 @@ void setpixel(SDL_Surface& surface, int x, int y, Uint32 data) noexcept
 	}
 }
 
+void auto_linebreaks(std::string& str, int n)
+{
+	int last_break = 0;
+	for(int i = 0; i < str.length(); i++) {
+		if(last_break + n <= i && std::isspace(str[i])) {
+			str[i] = '\n';
+			last_break = i;
+		}
+	}
+}
+
 }
@@ -130,7 +130,14 @@ class Sdl
 
 public:
 
-	explicit Sdl(uint32_t flags);
+	/**
+	 * Initialize the SDL library with the given subsystem flags.
+	 *
+	 * In @c headless mode, SDL uses the dummy video driver with a hidden window
+	 * and a software renderer. This allows drawing offscreen on machines without
+	 * a display, with pixels that do not depend on the graphics hardware.
+	 */
+	explicit Sdl(uint32_t flags, bool headless = false);
 	~Sdl();
 
 	// accessors
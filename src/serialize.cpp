@@ -0,0 +1,83 @@
+/**
+ * Implementation of binary encoding primitives.
+ */
+
+#include "serialize.hpp"
+#include "error.hpp"
+#include <cstring>
+
+void BinaryWriter::put_varint(std::uint64_t value) noexcept
+{
+	while(value >= 0x80) {
+		put_byte(static_cast<std::uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+
+	put_byte(static_cast<std::uint8_t>(value));
+}
+
+void BinaryWriter::put_signed(std::int64_t value) noexcept
+{
+	// zigzag: 0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4, ...
+	const std::uint64_t zigzag = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	put_varint(zigzag);
+}
+
+void BinaryWriter::put_float(float value) noexcept
+{
+	static_assert(sizeof(float) == sizeof(std::uint32_t));
+
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	for(int i = 0; i < 4; i++)
+		put_byte(static_cast<std::uint8_t>(bits >> (8 * i)));
+}
+
+std::uint8_t BinaryReader::get_byte()
+{
+	const std::uint8_t value = peek_byte();
+	m_pos++;
+	return value;
+}
+
+std::uint8_t BinaryReader::peek_byte() const
+{
+	if(m_pos >= m_size)
+		throwx<SerializeException>("Unexpected end of data at byte %zu.", m_pos);
+
+	return std::to_integer<std::uint8_t>(m_buffer[m_pos]);
+}
+
+std::uint64_t BinaryReader::get_varint()
+{
+	std::uint64_t value = 0;
+
+	for(int shift = 0; shift < 64; shift += 7) {
+		const std::uint8_t byte = get_byte();
+		value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+		if(!(byte & 0x80))
+			return value;
+	}
+
+	throwx<SerializeException>("Malformed varint before byte %zu.", m_pos);
+}
+
+std::int64_t BinaryReader::get_signed()
+{
+	const std::uint64_t zigzag = get_varint();
+	return static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+}
+
+float BinaryReader::get_float()
+{
+	std::uint32_t bits = 0;
+
+	for(int i = 0; i < 4; i++)
+		bits |= static_cast<std::uint32_t>(get_byte()) << (8 * i);
+
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
@@ -0,0 +1,94 @@
+/**
+ * serialize.hpp
+ * Primitives for compact binary encoding of game data.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Writes binary data into a buffer provided by the caller.
+ *
+ * The writer never allocates. If the buffer is too small, it continues to
+ * count the bytes that it would have written, but discards them.
+ * Afterwards, the caller can check for @ref overflow and retry with a buffer
+ * of the required @ref size.
+ *
+ * Integers are written as little-endian base-128 varints. Signed integers are
+ * zigzag-encoded first, so that small negative values stay short.
+ */
+class BinaryWriter
+{
+
+public:
+
+	explicit BinaryWriter(std::byte* buffer, std::size_t capacity) noexcept
+		: m_buffer(buffer), m_capacity(capacity), m_size(0) {}
+
+	void put_byte(std::uint8_t value) noexcept
+	{
+		if(m_size < m_capacity)
+			m_buffer[m_size] = std::byte{value};
+
+		m_size++;
+	}
+
+	void put_varint(std::uint64_t value) noexcept;
+	void put_signed(std::int64_t value) noexcept;
+	void put_float(float value) noexcept;
+
+	/**
+	 * Return the number of bytes written so far, including discarded bytes.
+	 */
+	std::size_t size() const noexcept { return m_size; }
+
+	/**
+	 * Return true if some of the data did not fit into the buffer.
+	 */
+	bool overflow() const noexcept { return m_size > m_capacity; }
+
+private:
+
+	std::byte* m_buffer; //!< destination memory
+	std::size_t m_capacity; //!< number of bytes available in the buffer
+	std::size_t m_size; //!< number of bytes written or required
+
+};
+
+/**
+ * Reads binary data as written by the @c BinaryWriter from a buffer.
+ *
+ * @throw SerializeException on any attempt to read past the end of the buffer.
+ */
+class BinaryReader
+{
+
+public:
+
+	explicit BinaryReader(const std::byte* buffer, std::size_t size) noexcept
+		: m_buffer(buffer), m_size(size), m_pos(0) {}
+
+	std::uint8_t get_byte();
+	std::uint64_t get_varint();
+	std::int64_t get_signed();
+	float get_float();
+
+	/**
+	 * Return the next byte without consuming it.
+	 */
+	std::uint8_t peek_byte() const;
+
+	/**
+	 * Return the number of bytes left to read.
+	 */
+	std::size_t remaining() const noexcept { return m_size - m_pos; }
+
+private:
+
+	const std::byte* m_buffer; //!< source memory
+	std::size_t m_size; //!< number of bytes in the buffer
+	std::size_t m_pos; //!< read position
+
+};
@@ -0,0 +1,86 @@
+/**
+ * Entry point of the headless game server.
+ *
+ * The server does not initialize SDL, open a window or load any assets.
+ * It runs the server loop directly on the main thread until it receives
+ * SIGINT or SIGTERM, upon which it finishes the current tick and exits.
+ * While it runs, it applies changes of the run-time settings in the
+ * configuration file, see @c ConfigWatcher.
+ */
+
+#include "network.hpp"
+#include "game.hpp"
+#include "configuration.hpp"
+#include "error.hpp"
+#include "context.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+
+namespace
+{
+
+/**
+ * The server loop runs as long as this flag is set.
+ */
+std::atomic<bool> running{true};
+
+static_assert(std::atomic<bool>::is_always_lock_free, "The signal handler requires a lock-free flag.");
+
+/**
+ * Signal handler for graceful shutdown.
+ */
+void request_shutdown(int ) noexcept
+{
+	running = false;
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	on_failure_break_into_debugger = false; // log errors instead of aborting
+
+	try {
+		Configuration configuration;
+		const std::filesystem::path CONFIG_PATH{std::string(APP_NAME) + ".conf"};
+		if(std::filesystem::is_regular_file(CONFIG_PATH)) {
+			configuration.read_from_file(CONFIG_PATH);
+		}
+		configuration.read_from_args(argc, argv);
+
+		configure_headless_context(configuration, create_file_log(configuration.log_path));
+
+		std::signal(SIGINT, request_shutdown);
+		std::signal(SIGTERM, request_shutdown);
+
+		std::unique_ptr<ConfigWatcher> watcher;
+		if(std::filesystem::is_regular_file(CONFIG_PATH)) {
+			watcher = std::make_unique<ConfigWatcher>(CONFIG_PATH, std::vector<std::string>(argv + 1, argv + argc));
+		}
+
+		Log::info("Headless server on port %d.", configuration.port);
+		const std::unique_ptr<IGame> game = make_server_game(static_cast<uint16_t>(configuration.port));
+		run_server_loop(*game, running, watcher.get());
+		Log::info("Server exit.");
+	}
+	catch(const std::exception& ex) {
+		// Errors in the configuration occur before there is a log.
+		if(the_context.log)
+			log_error(ex);
+		else
+			std::fprintf(stderr, "%s\n", ex.what());
+
+		return 1;
+	}
+	catch(...) {
+		if(the_context.log)
+			Log::error("Unknown exception occurred.");
+		else
+			std::fprintf(stderr, "Unknown exception occurred.\n");
+
+		return 1;
+	}
+
+	return 0;
+}
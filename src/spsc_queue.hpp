@@ -0,0 +1,117 @@
+/**
+ * Bounded lock-free queue for passing objects from one thread to another.
+ *
+ * Exactly one producer thread may push and exactly one consumer thread may
+ * pop at the same time. Neither side ever blocks; when the queue is full or
+ * empty, the operation fails and the caller decides whether to retry.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/**
+ * Ring buffer with one slot per element.
+ * The producer owns the write index, the consumer owns the read index.
+ * Each side publishes its own index with release semantics and reads the
+ * other one with acquire semantics, so that the element accesses are ordered.
+ *
+ * When both sides pass elements by exchange, the storage which the elements
+ * own circulates between the threads instead of being allocated on one side
+ * and freed on the other.
+ *
+ * @tparam T element type, must be default-constructible, movable and swappable
+ * @tparam Capacity maximum number of elements in the queue, a power of two
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+
+	static_assert(Capacity > 0 && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two.");
+
+public:
+
+	/**
+	 * Producer side: append the element to the queue.
+	 * If the queue is full, leave the element untouched and return false.
+	 */
+	bool push(T& element)
+	{
+		const size_t write = m_write.load(std::memory_order_relaxed);
+		if(write - m_read.load(std::memory_order_acquire) == Capacity)
+			return false;
+
+		m_slots[write & (Capacity - 1)] = std::move(element);
+		m_write.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Producer side: append the element to the queue like @c push.
+	 * In exchange, the element receives what the consumer left in the slot.
+	 */
+	bool push_exchange(T& element)
+	{
+		const size_t write = m_write.load(std::memory_order_relaxed);
+		if(write - m_read.load(std::memory_order_acquire) == Capacity)
+			return false;
+
+		using std::swap;
+		swap(m_slots[write & (Capacity - 1)], element);
+		m_write.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Consumer side: remove and return the oldest element, if any.
+	 */
+	std::optional<T> pop()
+	{
+		const size_t read = m_read.load(std::memory_order_relaxed);
+		if(read == m_write.load(std::memory_order_acquire))
+			return {};
+
+		std::optional<T> element{std::move(m_slots[read & (Capacity - 1)])};
+		m_read.store(read + 1, std::memory_order_release);
+		return element;
+	}
+
+	/**
+	 * Consumer side: exchange the oldest element, if any, for the given one.
+	 * The given one stays in the queue for the producer to reuse.
+	 * If the queue is empty, leave the element untouched and return false.
+	 */
+	bool pop_exchange(T& element)
+	{
+		const size_t read = m_read.load(std::memory_order_relaxed);
+		if(read == m_write.load(std::memory_order_acquire))
+			return false;
+
+		using std::swap;
+		swap(m_slots[read & (Capacity - 1)], element);
+		m_read.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Return true if the queue holds no elements.
+	 * From any other thread than the consumer, the answer may be outdated.
+	 */
+	bool empty() const noexcept
+	{
+		return m_read.load(std::memory_order_acquire) == m_write.load(std::memory_order_acquire);
+	}
+
+private:
+
+	std::array<T, Capacity> m_slots; //!< element storage, indexed modulo Capacity
+
+	// The indices only ever increase and wrap around together with size_t.
+	// They live on separate cache lines, so that the threads do not compete for them.
+	alignas(64) std::atomic<size_t> m_write{0}; //!< number of elements pushed so far
+	alignas(64) std::atomic<size_t> m_read{0}; //!< number of elements popped so far
+
+};
@@ -2,8 +2,11 @@
 #include "state.hpp"
 #include "draw.hpp"
 #include "event.hpp"
+#include "asset.hpp"
+#include "allocation.hpp"
 #include "error.hpp"
 #include <cassert>
+#include <cstdio>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327950288
@@ -135,15 +138,14 @@ ParticleGenerator::ParticleGenerator(const Point p, const int density, const flo
 void ParticleGenerator::trigger()
 {
 #define MY_PI           3.14159265358979323846f  /* pi */
-	static std::minstd_rand generator;
-	static std::uniform_real_distribution<float> orientation_distribution{ 0., 2.f * MY_PI };
-	static std::uniform_real_distribution<float> spd_distribution{ 1.f, 5.f };
-	static std::uniform_real_distribution<float> turn_distribution{ -.5f, .5f };
+	std::uniform_real_distribution<float> orientation_distribution{ 0., 2.f * MY_PI };
+	std::uniform_real_distribution<float> spd_distribution{ 1.f, 5.f };
+	std::uniform_real_distribution<float> turn_distribution{ -.5f, .5f };
 
 	for(int i = 0; i < m_density; i++) {
-		const float orientation = orientation_distribution(generator);
-		const float speed = spd_distribution(generator) * m_intensity;
-		const float turn = turn_distribution(generator);
+		const float orientation = orientation_distribution(m_random);
+		const float speed = spd_distribution(m_random) * m_intensity;
+		const float turn = turn_distribution(m_random);
 		const float gravity = .3f * m_intensity;
 		const int ttl = 10;
 		const float xspeed = std::cos(orientation) * speed;
@@ -448,15 +450,45 @@ const int DrawPit::CURSOR_FRAME_TIME = 4;
 const int DrawPit::CURSOR_FRAMES = 4;
 
 
-Stage::Stage(const GameState& state, IDraw& draw)
+namespace evt
+{
+
+BonusRelay::BonusRelay(Stage& stage)
+	: m_stage(&stage)
+{}
+
+void BonusRelay::fire(evt::Match event)
+{
+	if(event.combo > 3)
+		m_stage->sobs().at(event.trivia.player).bonus.display_combo(event.combo);
+}
+
+void BonusRelay::fire(evt::Chain event)
+{
+	if(event.counter > 0)
+		m_stage->sobs().at(event.trivia.player).bonus.display_chain(event.counter + 1);
+}
+
+void ShakeRelay::fire(evt::PhysicalLands lands)
+{
+	if(const Garbage* garbage = dynamic_cast<const Garbage*> (&lands.physical)) {
+		m_stage->shake(garbage->rows() * SHAKE_SCALE);
+	}
+}
+
+}
+
+
+Stage::Stage(const SnapshotHandle& snapshot, IDraw& draw)
 	:
-	m_state(&state),
+	m_snapshot(&snapshot),
 	m_draw(&draw),
 	m_bonus_relay(*this),
 	m_sound_relay(),
 	m_shake_relay(*this)
 {
-	enforce(2 == state.pit().size()); // different player number not supported yet
+	if(auto state = snapshot.get())
+		enforce(2 == state->pit().size()); // different player number not supported yet
 
 	Point lbanner_loc{LPIT_LOC.offset((PIT_W - BANNER_W) / 2., (PIT_H - BANNER_H) / 2.)};
 	m_sobs.push_back({Banner(lbanner_loc), BonusIndicator(LBONUS_LOC), PanicIndicator(LPIT_LOC, draw)});
@@ -467,10 +499,12 @@ Stage::Stage(const GameState& state, IDraw& draw)
 
 void Stage::update()
 {
+	const auto state = m_snapshot ? m_snapshot->get() : nullptr;
+
 	for(int i = 0; i < m_sobs.size(); i++) {
 		StageObjects& sob = m_sobs[i];
 		sob.bonus.update();
-		sob.panic.set_panic((m_state && !m_show_result) ? m_state->pit()[i]->panic() : 1.f);
+		sob.panic.set_panic((state && !m_show_result) ? state->pit()[i]->panic() : 1.f);
 		sob.panic.update();
 	}
 
@@ -492,12 +526,15 @@ void Stage::draw(float dt) const
 
 	draw_background();
 
-	if(m_state) {
+	// hold on to one snapshot for the whole frame
+	const auto state = m_snapshot ? m_snapshot->get() : nullptr;
+
+	if(state) {
 		DrawPit draw_pit{*m_draw, dt, m_shake, m_show_result, m_show_pit_debug_overlay, m_show_pit_debug_highlight};
 
 		for(size_t i = 0; i < m_sobs.size(); ++i) {
 			const StageObjects& sob = m_sobs[i];
-			draw_pit.run(*m_state->pit()[i]);
+			draw_pit.run(*state->pit()[i]);
 			draw_bonus(sob.bonus, dt);
 
 			if(m_show_result) {
@@ -509,6 +546,9 @@ void Stage::draw(float dt) const
 	}
 
 	tint();
+
+	if(m_show_pit_debug_overlay && allocation_counting())
+		draw_allocations();
 }
 
 void Stage::fade(float black_fraction)
@@ -602,6 +642,23 @@ void Stage::draw_banner(const Banner& banner, float dt) const
 	m_draw->gfx(loc, Gfx::BANNER, static_cast<size_t>(banner.frame));
 }
 
+void Stage::draw_allocations() const
+{
+	if(!m_debug_font)
+		m_debug_font = std::make_unique<BitmapFont>(*the_context.sdl, the_context.assets->charset(), wrap::BLACK, wrap::WHITE);
+
+	const AllocationCounts counts = tick_allocations();
+	char line[32];
+
+	for(size_t i = 0; i < ALLOC_PHASES; i++) {
+		std::snprintf(line, sizeof(line), "%-10s %ld", alloc_phase_name(static_cast<AllocPhase>(i)), counts.allocations[i]);
+		m_draw->text_fixed(8, 8 + static_cast<int>(i) * BITMAP_FONT_LINEHEIGHT, *m_debug_font, line);
+	}
+
+	std::snprintf(line, sizeof(line), "HEAP %ldK", counts.bytes / 1024);
+	m_draw->text_fixed(8, 8 + static_cast<int>(ALLOC_PHASES) * BITMAP_FONT_LINEHEIGHT, *m_debug_font, line);
+}
+
 void Stage::tint() const
 {
 	m_draw->rect({ 0, 0, CANVAS_W, CANVAS_H }, { 0, 0, 0, static_cast<uint8_t>(m_black_fraction * 255) });
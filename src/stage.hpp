@@ -6,6 +6,7 @@
 #include "globals.hpp"
 #include "event.hpp"
 #include "text.hpp"
+#include <random>
 
 class IDraw;
 
@@ -243,6 +244,7 @@ private:
 	int m_density; //!< number of particles spawned per trigger
 	float m_intensity; //!< influences speed, gravity and ttl
 	IDraw* m_draw; //!< drawing object
+	std::minstd_rand m_random; //!< own source of randomness, so that every stage plays out the same
 
 	std::vector<std::unique_ptr<IParticle>> m_particles;
 
@@ -361,7 +363,12 @@ class Stage
 
 public:
 
-	explicit Stage(const GameState& state, IDraw& draw);
+	/**
+	 * Construct the stage to show the game state published by the given handle.
+	 * The stage only reads the snapshots, so that it need not share the
+	 * simulation's view of the live state.
+	 */
+	explicit Stage(const SnapshotHandle& snapshot, IDraw& draw);
 	Stage(const Stage& ) =delete;
 
 	/**
@@ -420,8 +427,11 @@ public:
 	 */
 	void unsubscribe_from(evt::GameEventHub& hub);
 
-	void set_state(const GameState* state) { m_state = state; }
-	const GameState& state() const { return *m_state; }
+	/**
+	 * Change the source of the displayed game state.
+	 * With nullptr, the stage draws no pits.
+	 */
+	void set_snapshot(const SnapshotHandle* snapshot) { m_snapshot = snapshot; }
 	SobVector& sobs() { return m_sobs; }
 	const SobVector& sobs() const { return m_sobs; }
 
@@ -429,7 +439,7 @@ public:
 
 private:
 
-	const GameState* m_state;
+	const SnapshotHandle* m_snapshot; //!< source of the displayed game state
 	IDraw* m_draw;
 	SobVector m_sobs;
 	evt::BonusRelay m_bonus_relay;
@@ -443,12 +453,19 @@ private:
 	float m_black_fraction = 1.f; //!< fade fraction for the intro phase fade-in blend effect
 	Point m_pitloc{0,0}; //!< point location of the current pit, translate sprites
 	uint8_t m_alpha = 255;
+	mutable std::unique_ptr<BitmapFont> m_debug_font; //!< font for debug text, created on first use
 
 	// drawing implementation routines
 	void draw_background() const;
 	void draw_bonus(const BonusIndicator& bonus, float dt) const;
 	void draw_banner(const Banner& banner, float dt) const;
 
+	/**
+	 * Draw the number of heap allocations by phase in the latest tick.
+	 * Requires an instrumentation build, see allocation.hpp.
+	 */
+	void draw_allocations() const;
+
 	/**
 	 * Apply the configured m_fade value to the screen.
 	 */
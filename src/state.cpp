@@ -1,11 +1,105 @@
 #include "state.hpp"
+#include "serialize.hpp"
+#include "allocation.hpp"
 #include "error.hpp"
+#include <algorithm>
+#include <type_traits>
+#include <climits>
 #include <cassert>
+#include <atomic>
+#include <string_view>
 
 // only for debug functions
 #include <iostream>
 #include <iomanip>
 
+namespace
+{
+
+// Value representations for state diffs
+
+std::string diff_value(int value) { return std::to_string(value); }
+std::string diff_value(long value) { return std::to_string(value); }
+std::string diff_value(size_t value) { return std::to_string(value); }
+std::string diff_value(bool value) { return value ? "true" : "false"; }
+std::string diff_value(RowCol rc) { return string_format("%d,%d", rc.r, rc.c); }
+std::string diff_value(Point point) { return string_format("%g,%g", point.x, point.y); }
+std::string diff_value(Color color) { return color_to_string(color); }
+std::string diff_value(std::string_view value) { return std::string{value}; }
+
+template<typename Enum, typename = std::enable_if_t<std::is_enum_v<Enum>>>
+std::string diff_value(Enum value) { return std::to_string(static_cast<int>(value)); }
+
+/**
+ * Return the description of a differing field.
+ */
+template<typename T>
+StateDiff make_diff(const char* field, const T& lhs, const T& rhs)
+{
+	StateDiff diff;
+	diff.field = field;
+	diff.lhs = diff_value(lhs);
+	diff.rhs = diff_value(rhs);
+	return diff;
+}
+
+/**
+ * Return the name of the dynamic type of the physical.
+ */
+std::string_view physical_kind(const Physical& physical) noexcept
+{
+	return dynamic_cast<const Block*>(&physical) ? "Block" : "Garbage";
+}
+
+// Binary representation helpers
+
+constexpr std::uint8_t KIND_GARBAGE = 0x01; //!< type byte flag: garbage if set, block if clear
+
+/**
+ * Read a signed integer and check that it lies within the given bounds.
+ */
+int get_int(BinaryReader& reader, int min = INT_MIN, int max = INT_MAX)
+{
+	const std::int64_t value = reader.get_signed();
+
+	if(value < min || value > max)
+		throwx<SerializeException>("Value %lld out of range [%d, %d].", static_cast<long long>(value), min, max);
+
+	return static_cast<int>(value);
+}
+
+/**
+ * Read an unsigned count and check that it does not exceed the given maximum.
+ */
+std::size_t get_count(BinaryReader& reader, std::size_t max)
+{
+	const std::uint64_t value = reader.get_varint();
+
+	if(value > max)
+		throwx<SerializeException>("Count %llu exceeds %zu.", static_cast<unsigned long long>(value), max);
+
+	return static_cast<std::size_t>(value);
+}
+
+/**
+ * Interpret the 3- or 4-bit value as a color.
+ */
+Color to_color(int value)
+{
+	if(value > static_cast<int>(Color::ORANGE))
+		throwx<SerializeException>("Invalid color %d.", value);
+
+	return static_cast<Color>(value);
+}
+
+}
+
+std::string StateDiff::to_string() const
+{
+	return string_format("t=%ld pit=%d object=%d %s: %s != %s",
+		game_time, pit, object, field.c_str(), lhs.c_str(), rhs.c_str());
+}
+
 Physical::Physical(RowCol rc, State state)
 : m_rc(rc),
   m_state(state),
@@ -68,6 +162,51 @@ void Physical::continue_state(int time_bonus) noexcept
 	m_time += time_bonus;
 }
 
+void Physical::encode(BinaryWriter& writer) const
+{
+	encode_impl(writer);
+
+	// 3 bits state, 5 bits tags
+	writer.put_byte(static_cast<std::uint8_t>(static_cast<int>(m_state) | m_tag << 3));
+	writer.put_signed(m_rc.r);
+	writer.put_signed(m_rc.c);
+	writer.put_signed(m_time);
+	writer.put_signed(m_speed);
+}
+
+std::unique_ptr<Physical> Physical::decode(BinaryReader& reader)
+{
+	std::unique_ptr<Physical> physical;
+
+	// construct a placeholder of the right type, which the data then overwrites
+	if(reader.peek_byte() & KIND_GARBAGE)
+		physical = std::make_unique<Garbage>(RowCol{0, 0}, 1, 1, Loot{Color::FAKE});
+	else
+		physical = std::make_unique<Block>(Color::FAKE, RowCol{0, 0}, Block::State::REST);
+
+	physical->decode_impl(reader);
+
+	const std::uint8_t state_tag = reader.get_byte();
+	physical->m_state = static_cast<State>(state_tag & 0x07);
+	physical->m_tag = static_cast<Tag>(state_tag >> 3);
+	physical->m_rc.r = get_int(reader);
+	physical->m_rc.c = get_int(reader, 0, PIT_COLS - 1);
+	physical->m_time = get_int(reader);
+	physical->m_speed = get_int(reader);
+
+	return physical;
+}
+
+std::optional<StateDiff> Physical::diff(const Physical& rhs) const
+{
+	if(!(m_rc == rhs.m_rc)) return make_diff("rc", m_rc, rhs.m_rc);
+	if(m_state != rhs.m_state) return make_diff("state", m_state, rhs.m_state);
+	if(m_time != rhs.m_time) return make_diff("time", m_time, rhs.m_time);
+	if(m_speed != rhs.m_speed) return make_diff("speed", m_speed, rhs.m_speed);
+	if(m_tag != rhs.m_tag) return make_diff("tag", m_tag, rhs.m_tag);
+	return {};
+}
+
 
 Block::Block(Color col, RowCol rc, State state)
 : Physical(rc, static_cast<Physical::State>(state)),
@@ -103,6 +242,50 @@ bool Block::is_matchable() const noexcept
 	return State::REST == state || State::LAND == state;
 }
 
+void Block::encode_impl(BinaryWriter& writer) const
+{
+	// type byte: 1 bit kind, 3 bits color, 1 bit chaining, 3 bits animation
+	const int packed = static_cast<int>(col) << 1 | (chaining ? 1 : 0) << 4 | static_cast<int>(m_anim) << 5;
+	writer.put_byte(static_cast<std::uint8_t>(packed));
+}
+
+void Block::decode_impl(BinaryReader& reader)
+{
+	const std::uint8_t packed = reader.get_byte();
+	const int anim = packed >> 5;
+
+	if(anim > static_cast<int>(BlockFrame::BREAK_END))
+		throwx<SerializeException>("Invalid block animation frame %d.", anim);
+
+	col = to_color(packed >> 1 & 0x07);
+	chaining = packed & 0x10;
+	m_anim = static_cast<BlockFrame>(anim);
+}
+
+std::optional<StateDiff> Block::diff(const Physical& rhs) const
+{
+	if(auto base_diff = Physical::diff(rhs))
+		return base_diff;
+
+	assert(dynamic_cast<const Block*>(&rhs));
+	const Block& block = static_cast<const Block&>(rhs);
+
+	if(col != block.col) return make_diff("col", col, block.col);
+	if(chaining != block.chaining) return make_diff("chaining", chaining, block.chaining);
+	if(m_anim != block.m_anim) return make_diff("anim", m_anim, block.m_anim);
+	return {};
+}
+
+bool Block::assign(const Physical& rhs)
+{
+	const Block* block = dynamic_cast<const Block*>(&rhs);
+	if(!block)
+		return false;
+
+	*this = *block;
+	return true;
+}
+
 void Block::update_impl()
 {
 	if(State::BREAK == block_state() && is_arriving()) {
@@ -157,6 +340,75 @@ int Garbage::shrink() noexcept
 	return m_rows;
 }
 
+void Garbage::encode_impl(BinaryWriter& writer) const
+{
+	writer.put_byte(KIND_GARBAGE);
+	writer.put_varint(static_cast<std::uint64_t>(m_columns));
+	writer.put_varint(static_cast<std::uint64_t>(m_rows));
+
+	// two colors per byte
+	for(size_t i = 0; i < m_loot.size(); i += 2) {
+		int packed = static_cast<int>(m_loot[i]);
+		if(i + 1 < m_loot.size())
+			packed |= static_cast<int>(m_loot[i + 1]) << 4;
+
+		writer.put_byte(static_cast<std::uint8_t>(packed));
+	}
+}
+
+void Garbage::decode_impl(BinaryReader& reader)
+{
+	reader.get_byte(); // type byte holds no further information
+
+	const std::size_t columns = get_count(reader, PIT_COLS);
+	const std::size_t rows = get_count(reader, reader.remaining() * 2);
+	const std::size_t loot_size = columns * rows;
+
+	if(0 == columns || 0 == rows || reader.remaining() < (loot_size + 1) / 2)
+		throwx<SerializeException>("Invalid garbage of %zu columns and %zu rows.", columns, rows);
+
+	Loot loot;
+	loot.reserve(loot_size);
+
+	for(size_t i = 0; i < loot_size; i += 2) {
+		const std::uint8_t packed = reader.get_byte();
+		loot.push_back(to_color(packed & 0x0f));
+		if(i + 1 < loot_size)
+			loot.push_back(to_color(packed >> 4));
+	}
+
+	m_columns = static_cast<int>(columns);
+	m_rows = static_cast<int>(rows);
+	m_loot = move(loot);
+}
+
+std::optional<StateDiff> Garbage::diff(const Physical& rhs) const
+{
+	if(auto base_diff = Physical::diff(rhs))
+		return base_diff;
+
+	assert(dynamic_cast<const Garbage*>(&rhs));
+	const Garbage& garbage = static_cast<const Garbage&>(rhs);
+
+	if(m_columns != garbage.m_columns) return make_diff("columns", m_columns, garbage.m_columns);
+	if(m_rows != garbage.m_rows) return make_diff("rows", m_rows, garbage.m_rows);
+	if(m_loot.size() != garbage.m_loot.size()) return make_diff("loot.size", m_loot.size(), garbage.m_loot.size());
+
+	const auto [lhs_it, rhs_it] = std::mismatch(m_loot.begin(), m_loot.end(), garbage.m_loot.begin());
+	if(m_loot.end() != lhs_it) return make_diff("loot", *lhs_it, *rhs_it);
+	return {};
+}
+
+bool Garbage::assign(const Physical& rhs)
+{
+	const Garbage* garbage = dynamic_cast<const Garbage*>(&rhs);
+	if(!garbage)
+		return false;
+
+	*this = *garbage; // the loot keeps its capacity
+	return true;
+}
+
 
 Pit::Pit(const Point loc, const Rules rules) noexcept
 : m_loc(loc),
@@ -172,6 +424,7 @@ Pit::Pit(const Point loc, const Rules rules) noexcept
   m_chain(0),
   m_recovery(0),
   m_panic(PANIC_TIME),
+  m_asleep(false),
   m_highlight_row(0)
 {
 	enforce(m_rules.cursor_delay >= 0);
@@ -187,8 +440,7 @@ Pit::Pit(const Pit& rhs)
 Pit& Pit::operator=(const Pit& rhs)
 {
 	assign_basic(rhs);
-	m_contents = rhs.copy_contents();
-	make_content_map();
+	assign_contents(rhs);
 	return *this;
 }
 
@@ -215,7 +467,7 @@ bool Pit::is_full() const noexcept
 {
 	auto is_above = [t = top()] (const PhysVec::value_type& p)
 	{
-		return Physical::State::REST == p->physical_state() && p->rc().r < t;
+		return overflows(*p, t);
 	};
 
 	return m_contents.end() != std::find_if(m_contents.begin(), m_contents.end(), is_above);
@@ -238,6 +490,7 @@ Block& Pit::spawn_block(Color color, RowCol rc, Block::State state)
 	if(rc.r < m_peak)
 		m_peak = rc.r;
 
+	m_asleep = false;
 	return *raw_block;
 }
 
@@ -260,6 +513,7 @@ Garbage& Pit::spawn_garbage(RowCol rc, int width, int height, Loot loot)
 	if(rc.r < m_peak)
 		m_peak = rc.r;
 
+	m_asleep = false;
 	return *raw_garbage;
 }
 
@@ -322,6 +576,8 @@ void Pit::swap(Block& left, Block& right)
 
 	// To enable skill chains, the chaining marker stays with the falling block
 	std::swap(left.chaining, right.chaining);
+
+	m_asleep = false;
 }
 
 void Pit::remove_dead()
@@ -393,6 +649,7 @@ void Pit::cursor_stop(Dir dir) noexcept
 void Pit::set_raise(bool raise)
 {
 	m_want_raise = raise;
+	m_asleep = false;
 
 	if(m_want_raise) {
 		m_raise = true;
@@ -443,12 +700,29 @@ Point Pit::transform(Point point, float dt) const noexcept
 
 void Pit::update()
 {
-	for(auto& p : m_contents)
+	AllocationScope scope{AllocPhase::PIT_UPDATE};
+
+	for(auto& p : m_contents) {
 		p->update();
 
+		// Objects that do anything but rest need the logic to look at them.
+		// Garbage does not use the extended states, so this test suffices.
+		const Physical::State state = p->physical_state();
+		if(Physical::State::REST != state &&
+		   Block::State::PREVIEW != static_cast<Block::State>(state))
+			m_asleep = false;
+	}
+
+	const int old_top = top();
+	const int old_bottom = bottom();
+
 	if(m_enabled)
 		m_scroll += m_raise ? RAISE_SPEED : m_speed;
 
+	// A new row of blocks may become active or the pit may run full.
+	if(old_top != top() || old_bottom != bottom())
+		m_asleep = false;
+
 	// Cursor: repeat input direction, keep in bounds
 	while(m_cursor.rc.r < top())
 		m_cursor.rc.r++;
@@ -471,6 +745,145 @@ void Pit::update()
 	}
 }
 
+void Cursor::encode(BinaryWriter& writer) const
+{
+	writer.put_signed(rc.r);
+	writer.put_signed(rc.c);
+	writer.put_byte(static_cast<std::uint8_t>(dir));
+	writer.put_signed(repeat_time);
+	writer.put_signed(anim_time);
+}
+
+Cursor Cursor::decode(BinaryReader& reader)
+{
+	Cursor cursor;
+	cursor.rc.r = get_int(reader);
+	cursor.rc.c = get_int(reader, 0, PIT_COLS - 2);
+
+	const std::uint8_t dir = reader.get_byte();
+	if(dir > static_cast<std::uint8_t>(Dir::DOWN))
+		throwx<SerializeException>("Invalid cursor direction %d.", dir);
+
+	cursor.dir = static_cast<Dir>(dir);
+	cursor.repeat_time = get_int(reader);
+	cursor.anim_time = get_int(reader);
+	return cursor;
+}
+
+void Pit::encode(BinaryWriter& writer) const
+{
+	writer.put_float(m_loc.x);
+	writer.put_float(m_loc.y);
+	writer.put_varint(static_cast<std::uint64_t>(m_rules.cursor_delay));
+	writer.put_signed(m_rules.input_delay);
+	m_cursor.encode(writer);
+
+	const int flags = (m_want_raise ? 1 : 0) | (m_raise ? 2 : 0) | (m_enabled ? 4 : 0) | (m_asleep ? 8 : 0);
+	writer.put_byte(static_cast<std::uint8_t>(flags));
+
+	writer.put_signed(m_scroll);
+	writer.put_signed(m_speed);
+	writer.put_signed(m_peak);
+	writer.put_signed(m_floor);
+	writer.put_signed(m_chain);
+	writer.put_signed(m_recovery);
+	writer.put_signed(m_panic);
+	writer.put_signed(m_highlight_row);
+
+	writer.put_varint(m_contents.size());
+	for(const auto& physical : m_contents)
+		physical->encode(writer);
+}
+
+std::unique_ptr<Pit> Pit::decode(BinaryReader& reader)
+{
+	Point loc;
+	loc.x = reader.get_float();
+	loc.y = reader.get_float();
+
+	Rules rules;
+	rules.cursor_delay = static_cast<int>(get_count(reader, INT_MAX));
+	rules.input_delay = get_int(reader, INPUT_DELAY_AUTO, MAX_INPUT_DELAY);
+
+	auto pit = std::make_unique<Pit>(loc, rules);
+	pit->m_cursor = Cursor::decode(reader);
+
+	const std::uint8_t flags = reader.get_byte();
+	pit->m_want_raise = flags & 1;
+	pit->m_raise = flags & 2;
+	pit->m_enabled = flags & 4;
+	pit->m_asleep = flags & 8;
+
+	pit->m_scroll = get_int(reader);
+	pit->m_speed = get_int(reader);
+	pit->m_peak = get_int(reader);
+	pit->m_floor = get_int(reader);
+	pit->m_chain = get_int(reader, 0);
+	pit->m_recovery = get_int(reader);
+	pit->m_panic = get_int(reader);
+	pit->m_highlight_row = get_int(reader);
+
+	// every physical takes more than one byte
+	const std::size_t count = get_count(reader, reader.remaining());
+	for(std::size_t i = 0; i < count; i++)
+		pit->m_contents.push_back(Physical::decode(reader));
+
+	try {
+		pit->make_content_map();
+	}
+	catch(const LogicException& ex) {
+		throwx<SerializeException>(ex, "Invalid pit contents.");
+	}
+
+	return pit;
+}
+
+std::optional<StateDiff> Pit::diff(const Pit& rhs) const
+{
+	if(m_loc.x != rhs.m_loc.x || m_loc.y != rhs.m_loc.y) return make_diff("loc", m_loc, rhs.m_loc);
+	if(m_rules.cursor_delay != rhs.m_rules.cursor_delay) return make_diff("rules.cursor_delay", m_rules.cursor_delay, rhs.m_rules.cursor_delay);
+	if(m_rules.input_delay != rhs.m_rules.input_delay) return make_diff("rules.input_delay", m_rules.input_delay, rhs.m_rules.input_delay);
+	if(!(m_cursor.rc == rhs.m_cursor.rc)) return make_diff("cursor.rc", m_cursor.rc, rhs.m_cursor.rc);
+	if(m_cursor.dir != rhs.m_cursor.dir) return make_diff("cursor.dir", m_cursor.dir, rhs.m_cursor.dir);
+	if(m_cursor.repeat_time != rhs.m_cursor.repeat_time) return make_diff("cursor.repeat_time", m_cursor.repeat_time, rhs.m_cursor.repeat_time);
+	if(m_cursor.anim_time != rhs.m_cursor.anim_time) return make_diff("cursor.anim_time", m_cursor.anim_time, rhs.m_cursor.anim_time);
+	if(m_want_raise != rhs.m_want_raise) return make_diff("want_raise", m_want_raise, rhs.m_want_raise);
+	if(m_raise != rhs.m_raise) return make_diff("raise", m_raise, rhs.m_raise);
+	if(m_enabled != rhs.m_enabled) return make_diff("enabled", m_enabled, rhs.m_enabled);
+	if(m_scroll != rhs.m_scroll) return make_diff("scroll", m_scroll, rhs.m_scroll);
+	if(m_speed != rhs.m_speed) return make_diff("speed", m_speed, rhs.m_speed);
+	if(m_peak != rhs.m_peak) return make_diff("peak", m_peak, rhs.m_peak);
+	if(m_floor != rhs.m_floor) return make_diff("floor", m_floor, rhs.m_floor);
+	if(m_chain != rhs.m_chain) return make_diff("chain", m_chain, rhs.m_chain);
+	if(m_recovery != rhs.m_recovery) return make_diff("recovery", m_recovery, rhs.m_recovery);
+	if(m_panic != rhs.m_panic) return make_diff("panic", m_panic, rhs.m_panic);
+	if(m_highlight_row != rhs.m_highlight_row) return make_diff("highlight_row", m_highlight_row, rhs.m_highlight_row);
+	if(m_contents.size() != rhs.m_contents.size()) return make_diff("contents.size", m_contents.size(), rhs.m_contents.size());
+
+	for(size_t i = 0; i < m_contents.size(); i++) {
+		const Physical& lhs_physical = *m_contents[i];
+		const Physical& rhs_physical = *rhs.m_contents[i];
+		std::optional<StateDiff> diff;
+
+		const std::string_view lhs_kind = physical_kind(lhs_physical);
+		const std::string_view rhs_kind = physical_kind(rhs_physical);
+
+		if(lhs_kind != rhs_kind)
+			diff = make_diff("kind", lhs_kind, rhs_kind);
+		else
+			diff = lhs_physical.diff(rhs_physical);
+
+		if(diff) {
+			diff->object = static_cast<int>(i);
+			return diff;
+		}
+	}
+
+	// The map is derived from the contents, so its size is the only independent information.
+	if(m_content_map.size() != rhs.m_content_map.size()) return make_diff("content_map.size", m_content_map.size(), rhs.m_content_map.size());
+	return {};
+}
+
 void Pit::refresh_peak() noexcept
 {
 	// maintain peak by linear search through the pit contents
@@ -497,10 +910,12 @@ void Pit::fall_block(Block& block)
 	if(at(to))
 		throwx<LogicException>("Pit: Attempt to move block to occupied location: to %dr %dc", to.r, to.c);
 
-	auto erased = m_content_map.erase(rc);
-	assert(1 == erased); // sanity check: this space must have been previously occupied
-	auto emplace_result = m_content_map.emplace(to, &block);
-	assert(emplace_result.second); // sanity check: this space must be free to place a block in
+	// Re-key the map node instead of erasing and allocating a new one.
+	auto node = m_content_map.extract(rc);
+	assert(!node.empty()); // sanity check: this space must have been previously occupied
+	node.key() = to;
+	auto insert_result = m_content_map.insert(std::move(node));
+	assert(insert_result.inserted); // sanity check: this space must be free to place a block in
 	block.set_rc(to);
 }
 
@@ -512,9 +927,23 @@ void Pit::fall_garbage(Garbage& garbage)
 	if(to.r + garbage.rows() - 1 >= m_floor)
 		throwx<LogicException>("Pit: Attempt to move garbage into or below the floor: to %dr %dc, h=%d, floor=%d", to.r, to.c, garbage.rows(), m_floor);
 
-	clear_area(garbage);
+	// The garbage leaves its top row and enters the row below its bottom.
+	// We move the map nodes of the top row there instead of reallocating them.
+	const int enter_row = rc.r + garbage.rows();
+
+	for(int c = rc.c; c < rc.c + garbage.columns(); c++) {
+		if(at({enter_row, c}))
+			throwx<LogicException>("Pit: Attempt to move garbage to occupied location: to %dr %dc", enter_row, c);
+	}
+
+	for(int c = rc.c; c < rc.c + garbage.columns(); c++) {
+		auto node = m_content_map.extract(RowCol{rc.r, c});
+		assert(!node.empty()); // sanity check: this space must have been previously occupied
+		node.key() = RowCol{enter_row, c};
+		m_content_map.insert(std::move(node));
+	}
+
 	garbage.set_rc(to);
-	fill_area(garbage);
 }
 
 void Pit::fill_area(Physical& physical)
@@ -524,9 +953,20 @@ void Pit::fill_area(Physical& physical)
 	for(int r = rc.r; r < rc.r + physical.rows(); r++) {
 		for(int c = rc.c; c < rc.c + physical.columns(); c++) {
 			RowCol target{r, c};
-			auto result = m_content_map.emplace(std::make_pair(target, &physical));
+			bool inserted;
+
+			if(m_spare_nodes.empty()) {
+				inserted = m_content_map.emplace(std::make_pair(target, &physical)).second;
+			}
+			else {
+				auto node = std::move(m_spare_nodes.back());
+				m_spare_nodes.pop_back();
+				node.key() = target;
+				node.mapped() = &physical;
+				inserted = m_content_map.insert(std::move(node)).inserted;
+			}
 
-			if(!result.second)
+			if(!inserted)
 				throwx<LogicException>("Pit: Attempt to block already blocked space at %dr %dc.", r, c);
 		}
 	}
@@ -560,6 +1000,7 @@ void Pit::assign_basic(const Pit& rhs)
 	m_chain = rhs.m_chain;
 	m_recovery = rhs.m_recovery;
 	m_panic = rhs.m_panic;
+	m_asleep = rhs.m_asleep;
 	m_highlight_row = rhs.m_highlight_row;
 }
 
@@ -574,6 +1015,28 @@ Pit::PhysVec Pit::copy_contents() const
 	return copy;
 }
 
+void Pit::assign_contents(const Pit& rhs)
+{
+	const size_t count = rhs.m_contents.size();
+	if(m_contents.size() > count)
+		m_contents.erase(m_contents.begin() + count, m_contents.end());
+
+	for(size_t i = 0; i < count; i++) {
+		const Physical& physical = *rhs.m_contents[i];
+
+		if(i >= m_contents.size())
+			m_contents.push_back(physical.clone());
+		else if(!m_contents[i]->assign(physical))
+			m_contents[i] = physical.clone();
+	}
+
+	// The map nodes of the old contents serve for the new contents.
+	for(auto it = m_content_map.begin(); it != m_content_map.end(); )
+		m_spare_nodes.push_back(m_content_map.extract(it++));
+
+	make_content_map();
+}
+
 void Pit::make_content_map()
 {
 	assert(m_content_map.empty()); // leftover content map
@@ -624,10 +1087,26 @@ GameState::GameState(GameState&& rhs) noexcept
 {
 }
 
-GameState& GameState::operator=(GameState rhs) noexcept
+GameState& GameState::operator=(const GameState& rhs)
 {
+	if(m_pit.size() == rhs.m_pit.size()) {
+		for(size_t i = 0; i < m_pit.size(); i++)
+			*m_pit[i] = *rhs.m_pit[i];
+	}
+	else {
+		m_pit.clear();
+		for(const auto& pit : rhs.m_pit)
+			m_pit.push_back(std::make_unique<Pit>(*pit));
+	}
+
 	m_game_time = rhs.m_game_time;
-	swap(m_pit, rhs.m_pit);
+	return *this;
+}
+
+GameState& GameState::operator=(GameState&& rhs) noexcept
+{
+	m_game_time = rhs.m_game_time;
+	m_pit = move(rhs.m_pit);
 	return *this;
 }
 
@@ -651,6 +1130,116 @@ int GameState::opponent(int player) const noexcept
 		return 0 == player ? 1 : 0;
 }
 
+std::optional<StateDiff> GameState::diff(const GameState& rhs) const
+{
+	std::optional<StateDiff> diff;
+
+	if(m_game_time != rhs.m_game_time) {
+		diff = make_diff("game_time", m_game_time, rhs.m_game_time);
+	}
+	else if(m_pit.size() != rhs.m_pit.size()) {
+		diff = make_diff("pit.size", m_pit.size(), rhs.m_pit.size());
+	}
+	else {
+		for(size_t i = 0; i < m_pit.size() && !diff; i++) {
+			diff = m_pit[i]->diff(*rhs.m_pit[i]);
+			if(diff)
+				diff->pit = static_cast<int>(i);
+		}
+	}
+
+	if(diff)
+		diff->game_time = m_game_time;
+
+	return diff;
+}
+
+void GameState::encode(BinaryWriter& writer) const
+{
+	writer.put_byte(FORMAT_VERSION);
+	writer.put_signed(m_game_time);
+	writer.put_varint(m_pit.size());
+
+	for(const auto& pit : m_pit)
+		pit->encode(writer);
+}
+
+GameState GameState::decode(BinaryReader& reader)
+{
+	const std::uint8_t version = reader.get_byte();
+	if(FORMAT_VERSION != version)
+		throwx<SerializeException>("Unsupported game state format version %d (expected %d).", version, FORMAT_VERSION);
+
+	GameState state{GameMeta{0, 0, false, Rules{}}};
+	state.m_game_time = static_cast<long>(get_int(reader, 0));
+
+	const std::size_t count = get_count(reader, MAX_CLIENTS);
+	for(std::size_t i = 0; i < count; i++)
+		state.m_pit.push_back(Pit::decode(reader));
+
+	return state;
+}
+
+std::optional<StateDiff> diff_lockstep(const GameState& lhs, const std::function<void()>& step_lhs,
+                                       const GameState& rhs, const std::function<void()>& step_rhs,
+                                       long end_time)
+{
+	while(true) {
+		if(auto diff = lhs.diff(rhs))
+			return diff;
+
+		if(lhs.game_time() >= end_time)
+			return {};
+
+		step_lhs();
+		step_rhs();
+	}
+}
+
+void SnapshotHandle::publish(const GameState& state)
+{
+	AllocationScope scope{AllocPhase::SNAPSHOT};
+
+	// Readers may still hold the spare, as they hold any earlier snapshot.
+	std::shared_ptr<GameState> snapshot = std::move(m_spare);
+	if(snapshot && 1 == snapshot.use_count()) {
+		std::atomic_thread_fence(std::memory_order_acquire); // readers are done with it
+		*snapshot = state;
+	}
+	else {
+		snapshot = std::make_shared<GameState>(state);
+	}
+
+	m_spare = std::move(m_own);
+	m_own = snapshot;
+	std::atomic_store(&m_snapshot, std::shared_ptr<const GameState>{std::move(snapshot)});
+}
+
+void SnapshotHandle::publish(std::shared_ptr<const GameState> state) noexcept
+{
+	if(m_own)
+		m_spare = std::move(m_own);
+
+	std::atomic_store(&m_snapshot, std::move(state));
+}
+
+void SnapshotHandle::share(const SnapshotHandle& other) noexcept
+{
+	std::atomic_store(&m_snapshot, other.get());
+}
+
+void SnapshotHandle::clear() noexcept
+{
+	m_own.reset();
+	m_spare.reset();
+	std::atomic_store(&m_snapshot, std::shared_ptr<const GameState>{});
+}
+
+std::shared_ptr<const GameState> SnapshotHandle::get() const noexcept
+{
+	return std::atomic_load(&m_snapshot);
+}
+
 [[ maybe_unused ]]
 void debug_print_pit(std::ostream& stream, const Pit& pit)
 {
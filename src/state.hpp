@@ -10,8 +10,33 @@
 #include <random>
 #include <memory>
 #include <functional>
+#include <optional>
 #include <ostream>
 
+class BinaryWriter;
+class BinaryReader;
+
+/**
+ * Describes the first difference found between two game states.
+ * Parts of the game state fill in what they know about the location.
+ */
+struct StateDiff
+{
+	static constexpr int NO_OBJECT = -1; //!< object value if the difference is not in the contents
+
+	long game_time = 0;      //!< time of the differing states
+	int pit = NOONE;         //!< number of the differing pit, if any
+	int object = NO_OBJECT;  //!< index of the differing physical in the pit contents, if any
+	std::string field;       //!< name of the differing field
+	std::string lhs;         //!< value of the field in the left-hand state
+	std::string rhs;         //!< value of the field in the right-hand state
+
+	/**
+	 * Return a human-readable description of the difference.
+	 */
+	std::string to_string() const;
+};
+
 /**
  * Base class for game objects that can be placed in the Pit.
  * All Physical objects occupy space according to their extents (rows and columns).
@@ -36,6 +61,7 @@ public:
 	Physical(RowCol rc, State state);
 	Physical(const Physical& ) =default;
 	Physical(Physical&& ) =default;
+	Physical& operator=(const Physical& ) =default;
 	virtual ~Physical() noexcept =default;
 
 	/**
@@ -43,6 +69,12 @@ public:
 	 */
 	virtual std::unique_ptr<Physical> clone() const =0;
 
+	/**
+	 * Overwrite this physical with a copy of the other, reusing its storage.
+	 * @return false if the other physical is of a different type and nothing was copied
+	 */
+	virtual bool assign(const Physical& rhs) =0;
+
 
 	RowCol rc() const noexcept { return m_rc; }
 	void set_rc(RowCol rc) noexcept { m_rc = rc; }
@@ -101,6 +133,24 @@ public:
 
 	void clear_tags() noexcept { m_tag = TAG_NONE; }
 
+	/**
+	 * Compare this physical to another of the same type, field by field.
+	 * @return the first differing field, if any
+	 */
+	virtual std::optional<StateDiff> diff(const Physical& rhs) const;
+
+	/**
+	 * Write the compact binary representation of the physical.
+	 * The first byte identifies the type of the physical.
+	 */
+	void encode(BinaryWriter& writer) const;
+
+	/**
+	 * Read a physical of any type from its binary representation.
+	 * @throw SerializeException if the data is invalid.
+	 */
+	static std::unique_ptr<Physical> decode(BinaryReader& reader);
+
 protected:
 
 	RowCol m_rc;    //!< row/col position, - is UP, + is DOWN
@@ -116,6 +166,16 @@ protected:
 	 */
 	virtual void set_state_impl(State state, int time, int speed) noexcept {}
 
+	/**
+	 * Template method for writing the subclass data, starting with the type byte.
+	 */
+	virtual void encode_impl(BinaryWriter& writer) const =0;
+
+	/**
+	 * Template method for reading the subclass data into this object.
+	 */
+	virtual void decode_impl(BinaryReader& reader) =0;
+
 private:
 
 	int m_time;     //!< number of steps until we consider a state switch
@@ -151,10 +211,12 @@ public:
 	Block(Color col, RowCol rc, State state);
 	Block(const Block& ) =default;
 	Block(Block&& ) =default;
+	Block& operator=(const Block& ) =default;
 
 	virtual ~Block() noexcept =default;
 
 	virtual std::unique_ptr<Physical> clone() const override { return std::make_unique<Block>(*this); }
+	virtual bool assign(const Physical& rhs) override;
 
 	virtual int rows() const noexcept override { return 1; }
 	virtual int columns() const noexcept override { return 1; }
@@ -166,6 +228,8 @@ public:
 	bool is_swappable() const noexcept;
 	bool is_matchable() const noexcept;
 
+	virtual std::optional<StateDiff> diff(const Physical& rhs) const override;
+
 private:
 
 	BlockFrame m_anim;  // current animation frame
@@ -179,6 +243,9 @@ private:
 	 * Block-specific state logic implementation.
 	 */
 	virtual void set_state_impl(Physical::State state, int, int) noexcept override;
+
+	virtual void encode_impl(BinaryWriter& writer) const override;
+	virtual void decode_impl(BinaryReader& reader) override;
 	
 };
 
@@ -219,9 +286,11 @@ public:
 	Garbage(RowCol rc, int columns, int rows, Loot loot);
 	Garbage(const Garbage& ) =default;
 	Garbage(Garbage&& ) =default;
+	Garbage& operator=(const Garbage& ) =default;
 	virtual ~Garbage() noexcept =default;
 
 	virtual std::unique_ptr<Physical> clone() const override { return std::make_unique<Garbage>(*this); }
+	virtual bool assign(const Physical& rhs) override;
 
 	virtual int rows() const noexcept override { return m_rows; }
 	virtual int columns() const noexcept override { return m_columns; }
@@ -240,12 +309,17 @@ public:
 	 */
 	int shrink() noexcept;
 
+	virtual std::optional<StateDiff> diff(const Physical& rhs) const override;
+
 private:
 
 	int m_columns;  //!< width of this garbage in blocks
 	int m_rows;     //!< height of this garbage in blocks
 	Loot m_loot; //!< row-major: bottom-to-top, left-to-right
 
+	virtual void encode_impl(BinaryWriter& writer) const override;
+	virtual void decode_impl(BinaryReader& reader) override;
+
 };
 
 
@@ -261,6 +335,13 @@ struct Cursor
 	Dir dir; //!< where the cursor is currently moving
 	int repeat_time; //!< number of updates until the cursor advances in its direction
 	int anim_time;  //!< animation frame timer
+
+	void encode(BinaryWriter& writer) const;
+
+	/**
+	 * @throw SerializeException if the data is invalid.
+	 */
+	static Cursor decode(BinaryReader& reader);
 };
 
 
@@ -339,6 +420,15 @@ public:
 	 */
 	bool is_full() const noexcept;
 
+	/**
+	 * Return true if the physical rests above the given top row of the pit.
+	 * A pit is full if this is true for any of its contents, see @c is_full.
+	 */
+	static bool overflows(const Physical& physical, int top) noexcept
+	{
+		return Physical::State::REST == physical.physical_state() && physical.rc().r < top;
+	}
+
 	/**
 	 * Create a new Block with the specified properties in the Pit.
 	 * Caution! This may invalidate all existing references to Blocks in the Pit.
@@ -498,6 +588,22 @@ public:
 
 	int highlight_row() const noexcept { return m_highlight_row; }
 
+	/**
+	 * Return true if the pit is sleeping.
+	 * A sleeping pit does nothing but scroll. All its contents are at rest
+	 * or in preview, and the logic has no need to look at it until it wakes.
+	 * The pit wakes on its own when new contents appear, blocks are swapped,
+	 * raise is requested, any object changes its state or scrolling reaches
+	 * a new row.
+	 */
+	bool asleep() const noexcept { return m_asleep; }
+
+	/**
+	 * Put the pit to sleep until the next change (see @ref asleep).
+	 * The BlockDirector calls this when it finds nothing to do in the pit.
+	 */
+	void sleep() noexcept { m_asleep = true; }
+
 	void stop() noexcept { m_enabled = false; }
 	void start() noexcept { m_enabled = true; }
 	void set_speed(int delta) { m_speed = delta; }
@@ -515,6 +621,26 @@ public:
 
 	void update();
 
+	/**
+	 * Compare this pit to another, field by field and object by object.
+	 * The contents must be equal in the same order.
+	 * The asleep flag is not compared, since it only marks a shortcut
+	 * of the logic and not a part of the game.
+	 * @return the first difference, if any
+	 */
+	std::optional<StateDiff> diff(const Pit& rhs) const;
+
+	/**
+	 * Write the compact binary representation of the pit and its contents.
+	 */
+	void encode(BinaryWriter& writer) const;
+
+	/**
+	 * Read a pit from its binary representation.
+	 * @throw SerializeException if the data is invalid.
+	 */
+	static std::unique_ptr<Pit> decode(BinaryReader& reader);
+
 private:
 
 	using PhysMap = std::unordered_map<RowCol, Physical*, RowColHash>;
@@ -533,9 +659,11 @@ private:
 	int m_chain;     //!< chain counter
 	int m_recovery;  //!< recover time pool; scrolling stops after a quality match
 	int m_panic;     //!< panic time pool; the player has this many ticks left until game over
+	bool m_asleep;   //!< whether the logic can skip this pit until something changes
 
 	PhysVec m_contents; // list of all blocks in the pit
 	PhysMap m_content_map; // sparse matrix of blocked spaces
+	std::vector<PhysMap::node_type> m_spare_nodes; // content map nodes kept for re-use by fill_area
 
 	int m_highlight_row;
 
@@ -546,6 +674,7 @@ private:
 	void clear_area(const Physical& physical); //!< Mark the area as not occupied.
 	void assign_basic(const Pit& rhs); //!< Copy basic members from rhs, used in impl of copy&move
 	PhysVec copy_contents() const; //!< Return a deep copy of m_contents.
+	void assign_contents(const Pit& rhs); //!< Copy the contents from rhs into the existing objects where possible.
 	void make_content_map(); //!< (Re-)build content map from m_contents.
 
 };
@@ -562,7 +691,13 @@ public:
 	GameState(const GameState& rhs);
 	GameState(GameState&& rhs) noexcept;
 
-	GameState& operator=(GameState rhs) noexcept;
+	/**
+	 * Copy the other state into this one.
+	 * The pits keep their storage where possible, so that repeated assignments
+	 * like rollbacks and recent checkpoints hardly allocate.
+	 */
+	GameState& operator=(const GameState& rhs);
+	GameState& operator=(GameState&& rhs) noexcept;
 
 	using PitVector = std::vector<std::unique_ptr<Pit>>;
 
@@ -578,6 +713,29 @@ public:
 	 */
 	int opponent(int player) const noexcept;
 
+	/**
+	 * Compare this state to another.
+	 * The comparison stops at the first difference and does not allocate
+	 * any memory until it finds one.
+	 * @return the first difference, if any
+	 */
+	std::optional<StateDiff> diff(const GameState& rhs) const;
+
+	static constexpr std::uint8_t FORMAT_VERSION = 2; //!< version of the binary representation
+
+	/**
+	 * Write the compact, versioned binary representation of the state.
+	 * To learn whether the state fit into the buffer, check the writer
+	 * for overflow afterwards.
+	 */
+	void encode(BinaryWriter& writer) const;
+
+	/**
+	 * Read a state from its binary representation.
+	 * @throw SerializeException if the data is invalid or of another version.
+	 */
+	static GameState decode(BinaryReader& reader);
+
 private:
 
 	PitVector m_pit; //!< state by player number
@@ -585,6 +743,76 @@ private:
 
 };
 
+/**
+ * Publishes immutable copies of the game state for readers outside the
+ * simulation, like the Stage or an Agent.
+ *
+ * The simulation may rewind and re-simulate its live state at any time.
+ * When it has calculated a tick which is worth showing, it publishes a copy.
+ * Readers get() a shared pointer to the latest copy, which stays consistent
+ * and alive for as long as they hold on to it, no matter what the simulation
+ * does in the meantime. The pointer is swapped atomically, so that neither
+ * side needs a lock.
+ */
+class SnapshotHandle
+{
+
+public:
+
+	/**
+	 * Make a copy of the given state available to readers.
+	 * Readers who hold an earlier snapshot keep it unchanged.
+	 * The copy goes into the storage of an earlier snapshot of this handle
+	 * if no reader holds that anymore.
+	 */
+	void publish(const GameState& state);
+
+	/**
+	 * Make the given immutable state available to readers without a copy.
+	 * This serves when another owner, like the Journal, has a copy already.
+	 */
+	void publish(std::shared_ptr<const GameState> state) noexcept;
+
+	/**
+	 * Make the latest snapshot of the other handle available to readers of
+	 * this one as well, without another copy.
+	 */
+	void share(const SnapshotHandle& other) noexcept;
+
+	/**
+	 * Withdraw the current snapshot. Readers will get() nullptr.
+	 */
+	void clear() noexcept;
+
+	/**
+	 * Return the latest published snapshot, or nullptr if there is none.
+	 */
+	std::shared_ptr<const GameState> get() const noexcept;
+
+private:
+
+	std::shared_ptr<const GameState> m_snapshot; //!< latest published state, access only atomically
+	std::shared_ptr<GameState> m_own; //!< our copy in m_snapshot, if it is one
+	std::shared_ptr<GameState> m_spare; //!< our copy before m_own, to re-use when readers let go
+
+};
+
+/**
+ * Run two simulations side by side and compare their states after every tick.
+ * Each step function must advance its own state by exactly one tick.
+ * This is meant to verify that two implementations of the logic agree.
+ *
+ * @param lhs state of the first simulation
+ * @param step_lhs advances the first simulation
+ * @param rhs state of the second simulation
+ * @param step_rhs advances the second simulation
+ * @param end_time the last tick to compare
+ * @return the first difference, if any
+ */
+std::optional<StateDiff> diff_lockstep(const GameState& lhs, const std::function<void()>& step_lhs,
+                                       const GameState& rhs, const std::function<void()>& step_rhs,
+                                       long end_time);
+
 /**
  * Write a list of the complete pit contents to the stream.
  */
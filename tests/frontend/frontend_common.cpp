@@ -0,0 +1,39 @@
+/**
+ * Shared helpers for unit tests of the SDL frontend.
+ */
+
+#include "frontend_common.hpp"
+#include "context.hpp"
+#include "sdl_helper.hpp"
+#include "asset.hpp"
+
+namespace
+{
+
+/**
+ * Adds the SDL library and the stub assets to the context
+ * which @c configure_context_for_testing prepares for the core.
+ */
+class FrontendEnvironment : public ::testing::Environment
+{
+
+public:
+
+	virtual void SetUp() override
+	{
+		the_context.sdl.reset(new Sdl(0));
+		the_context.assets.reset(new NoAssets);
+	}
+
+	virtual void TearDown() override
+	{
+		// SDL is an only-once resource, so shut it down before the next one may start.
+		the_context.assets.reset();
+		the_context.sdl.reset();
+	}
+
+};
+
+::testing::Environment* const frontend_environment = ::testing::AddGlobalTestEnvironment(new FrontendEnvironment);
+
+}
@@ -6,7 +6,7 @@
 #include "draw.hpp"
 #include "game.hpp"
 #include "agent.hpp"
-#include "tests_common.hpp"
+#include "frontend_common.hpp"
 
 class ScreenTest : public ::testing::Test
 {
@@ -3,9 +3,8 @@
  */
 
 #include "stage.hpp"
-#include "draw.hpp"
 #include "error.hpp"
-#include "tests_common.hpp"
+#include "frontend_common.hpp"
 #include <numeric>
 
 using testing::_;
@@ -22,13 +21,15 @@ public:
 		state = std::make_unique<GameState>(meta);
 		assets = std::make_unique<NoAssets>();
 		draw = std::make_unique<NoDraw>();
-		stage = std::make_unique<Stage>(*state, *draw);
+		snapshot.publish(*state);
+		stage = std::make_unique<Stage>(snapshot, *draw);
 		indicator = &stage->sobs().at(0).bonus;
 	}
 
 protected:
 
 	std::unique_ptr<GameState> state;
+	SnapshotHandle snapshot;
 	std::unique_ptr<Assets> assets;
 	std::unique_ptr<IDraw> draw;
 	std::unique_ptr<Stage> stage;
@@ -219,6 +219,19 @@ TEST_F(AgentTest, WantRaise)
 	EXPECT_EQ(ButtonAction::DOWN, raise_input->action);
 }
 
+/**
+ * With an input delay, the agent schedules its inputs that many ticks later.
+ */
+TEST_F(AgentTest, InputDelay)
+{
+	Agent agent(state, 0, 0);
+	agent.set_input_delay(3);
+	auto inputs = agent.move();
+
+	ASSERT_FALSE(inputs.empty());
+	EXPECT_EQ(4, inputs.front().game_time);
+}
+
 /**
  * When the Pit is filling up with blocks and still raising, the agent should
  * release the raise button.
@@ -0,0 +1,103 @@
+/**
+ * Tests for the allocation counters.
+ * The tests report allocations directly, so that they work with or without
+ * the allocation hooks.
+ */
+
+#include "allocation.hpp"
+#include "director.hpp"
+#include "tests_common.hpp"
+
+namespace
+{
+
+#if defined(SHITBRIX_COUNT_ALLOCATIONS)
+const AllocPhase SCOPED_PHASE = AllocPhase::CHECKPOINT;
+#else
+const AllocPhase SCOPED_PHASE = AllocPhase::OTHER; // scopes have no effect
+#endif
+
+long phase_count(const AllocationCounts& counts, AllocPhase phase)
+{
+	return counts.allocations[static_cast<size_t>(phase)];
+}
+
+}
+
+/**
+ * Test that allocations count towards the phase of the innermost scope.
+ */
+TEST(AllocationTest, ScopeAttribution)
+{
+	const AllocationCounts before = allocation_counts();
+
+	{
+		AllocationScope outer{AllocPhase::DRAW};
+		AllocationScope inner{AllocPhase::CHECKPOINT};
+		note_allocation(64);
+		note_deallocation(64);
+	}
+
+	const AllocationCounts counts = allocation_counts().since(before);
+	EXPECT_EQ(1, phase_count(counts, SCOPED_PHASE));
+	EXPECT_EQ(1, counts.total());
+}
+
+/**
+ * Test that the peak reflects the highest allocated bytes since the reset.
+ */
+TEST(AllocationTest, Peak)
+{
+	reset_allocation_peak();
+	const long base = allocation_counts().bytes;
+
+	note_allocation(1000);
+	note_allocation(500);
+	note_deallocation(1000);
+	note_deallocation(500);
+
+	const AllocationCounts counts = allocation_counts();
+	EXPECT_LE(base + 1500, counts.peak_bytes);
+}
+
+/**
+ * Test that the director does not allocate while blocks and garbage fall,
+ * land, match and break, as long as no inputs spawn new objects.
+ * Only the instrumentation build can count the allocations.
+ */
+TEST(AllocationTest, DirectorUpdateSteadyState)
+{
+	if(!allocation_counting())
+		GTEST_SKIP() << "allocation hooks are not linked";
+
+	GameState state{GameMeta{2, 0}};
+	Pit& pit = *state.pit().at(0);
+	BlockDirector director;
+	director.set_state(state);
+
+	prefill_pit(pit);
+	const std::array<Color, 6> colors{Color::BLUE, Color::RED, Color::YELLOW, Color::GREEN, Color::PURPLE, Color::ORANGE};
+	for(int c = 0; c < PIT_COLS; c++)
+		pit.spawn_block(colors[c % colors.size()], RowCol{0, c}, Block::State::REST);
+
+	// three blocks fall into a vertical match, a garbage falls next to them
+	for(int r : {-9, -7, -5}) {
+		Block& block = pit.spawn_block(Color::RED, RowCol{r, 0}, Block::State::REST);
+		block.set_state(Block::State::FALL, ROW_HEIGHT, FALL_SPEED);
+	}
+	Garbage& garbage = spawn_garbage(pit, {-12, 3}, 3, 1);
+	garbage.set_state(Physical::State::FALL, ROW_HEIGHT, FALL_SPEED);
+
+	const AllocationCounts before = allocation_counts();
+
+	const int FALL_T = (ROW_HEIGHT * 12 + FALL_SPEED - 1) / FALL_SPEED;
+	for(int t = 0; t < FALL_T + BREAK_TIME; t++) {
+		state.update();
+		director.update();
+	}
+
+	const AllocationCounts counts = allocation_counts().since(before);
+	EXPECT_EQ(Physical::State::REST, garbage.physical_state());
+	EXPECT_FALSE(pit.at({-1, 0})); // the match is gone
+	EXPECT_EQ(0, phase_count(counts, AllocPhase::DIRECTOR_UPDATE));
+}
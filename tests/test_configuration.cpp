@@ -0,0 +1,120 @@
+/**
+ * Tests for reading the configuration and applying run-time settings.
+ */
+
+#include "configuration.hpp"
+#include "tests_common.hpp"
+#include <fstream>
+
+namespace
+{
+
+/**
+ * Write the text into a configuration file in the temporary directory.
+ */
+std::filesystem::path write_config(const char* text)
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "shitbrix-test.conf";
+	std::ofstream{path, std::ios::binary} << text;
+	return path;
+}
+
+}
+
+/**
+ * Test that values from the file arrive in their typed members.
+ */
+TEST(ConfigurationTest, ReadFile)
+{
+	const auto path = write_config(
+		"# comment line\r\n"
+		"launch_mode = server\r\n"
+		"port=4711\n"
+		"ai_player 1\n"
+		"rules.cursor_delay = 3   \n"
+		"autorecord = true\n"
+		"server_url = example.org\n"
+		"log_level = info\n"
+		"net_batching = true");
+
+	Configuration configuration;
+	configuration.read_from_file(path);
+
+	EXPECT_EQ(LaunchMode::SERVER, configuration.launch_mode);
+	EXPECT_EQ(4711, configuration.port);
+	EXPECT_EQ(1, configuration.ai_player);
+	EXPECT_EQ(3, configuration.rules.cursor_delay);
+	EXPECT_TRUE(configuration.autorecord);
+	EXPECT_EQ("example.org", configuration.server_url);
+	EXPECT_EQ(Log::Level::INFO, configuration.log_level);
+	EXPECT_TRUE(configuration.net_batching);
+
+	std::filesystem::remove(path);
+}
+
+/**
+ * Test that both argument forms are accepted and override earlier values.
+ */
+TEST(ConfigurationTest, ReadArgs)
+{
+	const char* argv[] = {"shitbrix", "--port=4711", "--polls_per_tick", "4", "--player_number", ""};
+
+	Configuration configuration;
+	configuration.player_number = 1;
+	configuration.read_from_args(static_cast<int>(std::size(argv)), argv);
+
+	EXPECT_EQ(4711, configuration.port);
+	EXPECT_EQ(4, configuration.polls_per_tick);
+	EXPECT_FALSE(configuration.player_number.has_value());
+}
+
+/**
+ * Test that invalid keys and values are rejected.
+ */
+TEST(ConfigurationTest, Validation)
+{
+	Configuration configuration;
+
+	const char* unknown[] = {"shitbrix", "--no_such_key=1"};
+	EXPECT_THROW(configuration.read_from_args(2, unknown), ConfigException);
+
+	const char* range[] = {"shitbrix", "--port=70000"};
+	EXPECT_THROW(configuration.read_from_args(2, range), ConfigException);
+
+	const char* number[] = {"shitbrix", "--ai_level=hard"};
+	EXPECT_THROW(configuration.read_from_args(2, number), ConfigException);
+
+	const char* boolean[] = {"shitbrix", "--autorecord=yes"};
+	EXPECT_THROW(configuration.read_from_args(2, boolean), ConfigException);
+
+	const char* mode[] = {"shitbrix", "--launch_mode=solo"};
+	EXPECT_THROW(configuration.read_from_args(2, mode), ConfigException);
+
+	EXPECT_EQ(DEFAULT_PORT, configuration.port);
+}
+
+/**
+ * Test that the watcher applies a changed file to the run-time settings,
+ * while the command-line arguments keep their precedence.
+ */
+TEST(ConfigurationTest, Reload)
+{
+	const auto path = write_config("polls_per_tick = 2\nnet_batching = false\n");
+	ConfigWatcher watcher{path, {"--net_batching=true"}, std::chrono::milliseconds{0}};
+	EXPECT_FALSE(watcher.poll()); // nothing changed yet
+
+	write_config("polls_per_tick = 5\nnet_batching = false\nport = 4711\n");
+	std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds{2});
+	EXPECT_TRUE(watcher.poll());
+	EXPECT_EQ(5, runtime_settings().polls_per_tick.load());
+	EXPECT_TRUE(runtime_settings().net_batching.load());
+
+	// an invalid file leaves the settings unchanged
+	write_config("polls_per_tick = 0\n");
+	std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds{4});
+	EXPECT_FALSE(watcher.poll());
+	EXPECT_EQ(5, runtime_settings().polls_per_tick.load());
+
+	Configuration{}.apply_runtime(); // restore defaults for other tests
+	std::filesystem::remove(path);
+}
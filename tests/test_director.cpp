@@ -2,7 +2,6 @@
  * Tests for the game logic implementation in BlockDirector.
  */
 
-#include "stage.hpp"
 #include "director.hpp"
 #include "tests_common.hpp"
 
@@ -620,6 +619,33 @@ TEST_F(BlockDirectorTest, AboveGarbageFall)
 	EXPECT_EQ(top_garbage.rc().r, -7);
 }
 
+/**
+ * Tests whether objects resting on any column of a 3-wide garbage fall with it.
+ */
+TEST_F(BlockDirectorTest, WideFallAcrossColumns)
+{
+	// complete the test scenario
+	Block& block = pit->spawn_block(Color::YELLOW, RowCol{-4, 2}, Block::State::REST);
+	Garbage& garbage = spawn_garbage(*pit, {-5, 1}, 3, 1);
+	Block& left = pit->spawn_block(Color::RED, RowCol{-6, 1}, Block::State::REST);
+	Block& right = pit->spawn_block(Color::GREEN, RowCol{-6, 3}, Block::State::REST);
+	Block& tower = pit->spawn_block(Color::BLUE, RowCol{-7, 3}, Block::State::REST);
+
+	block.set_state(Physical::State::BREAK, 1);
+
+	// block should now disappear and everything fall at once
+	run_game_ticks(1);
+
+	EXPECT_EQ(garbage.physical_state(), Physical::State::FALL);
+	EXPECT_EQ(garbage.rc().r, -4);
+	EXPECT_EQ(left.physical_state(), Physical::State::FALL);
+	EXPECT_EQ(left.rc().r, -5);
+	EXPECT_EQ(right.physical_state(), Physical::State::FALL);
+	EXPECT_EQ(right.rc().r, -5);
+	EXPECT_EQ(tower.physical_state(), Physical::State::FALL);
+	EXPECT_EQ(tower.rc().r, -6);
+}
+
 /**
  * Tests whether physicals above a dissolved garbage correctly fall down.
  */
@@ -640,6 +666,28 @@ TEST_F(BlockDirectorTest, GarbageDissolveFall)
 	EXPECT_EQ(block.physical_state(), Physical::State::FALL);
 }
 
+/**
+ * Tests whether an idle pit goes to sleep and wakes up when something happens.
+ */
+TEST_F(BlockDirectorTest, SleepAndWake)
+{
+	Block& block = *pit->block_at({-3, 2});
+
+	// nothing is going on in the pit
+	run_game_ticks(1);
+	EXPECT_TRUE(pit->asleep());
+
+	// the block disappears, which must not be overlooked
+	block.set_state(Physical::State::BREAK, 1);
+	run_game_ticks(1);
+
+	EXPECT_FALSE(pit->at({-3, 2}));
+	EXPECT_TRUE(pit->asleep()); // idle again
+
+	pit->spawn_block(Color::BLUE, RowCol{-4, 2}, Block::State::REST);
+	EXPECT_FALSE(pit->asleep());
+}
+
 /**
  * Tests implementation of recovery time.
  */
@@ -2,7 +2,6 @@
  * Tests for the director’s usage of the IGameEvent interface.
  */
 
-#include "stage.hpp"
 #include "game.hpp"
 #include "director.hpp"
 #include "event.hpp"
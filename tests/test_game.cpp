@@ -176,6 +176,77 @@ TEST_F(GameTest, ClientGameRetract)
 	EXPECT_EQ(journal.inputs().size(), 2);
 }
 
+/**
+ * When the ClientGame receives the finalize message, it must reject any
+ * changes to the game up to the horizon.
+ */
+TEST_F(GameTest, ClientGameFinalize)
+{
+	Message meta_message{0, 0, MsgType::META, GameMeta{2, 0, false}.to_string()};
+	Message start_message{0, 0, MsgType::START, {}};
+	EXPECT_CALL(*m_client_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{meta_message, start_message}));
+	client_game->poll();
+	ASSERT_TRUE(client_game->switches().ingame);
+
+	Message finalize_message{0, 0, MsgType::FINALIZE, "10"};
+	Message retract_message{0, 0, MsgType::RETRACT, "9"};
+	Message input_message{0, 0, MsgType::INPUT, std::string(Input{PlayerInput{10, 0, GameButton::SWAP, ButtonAction::DOWN}})};
+	EXPECT_CALL(*m_client_channel, poll()).Times(3)
+		.WillOnce(Return(std::vector<Message>{finalize_message}))
+		.WillOnce(Return(std::vector<Message>{retract_message}))
+		.WillOnce(Return(std::vector<Message>{input_message}));
+
+	client_game->poll();
+	EXPECT_EQ(10, m_client_factory->m_journal_ptr->horizon());
+	EXPECT_THROW(client_game->poll(), GameException);
+	EXPECT_THROW(client_game->poll(), GameException);
+}
+
+/**
+ * In adaptive mode, the ClientGame delays local inputs by their measured
+ * round trip through the server. Otherwise, the delay comes from the rules.
+ */
+TEST_F(GameTest, ClientGameInputDelay)
+{
+	Rules rules;
+	rules.input_delay = INPUT_DELAY_AUTO;
+	Message meta_message{0, 0, MsgType::META, GameMeta{2, 0, false, rules}.to_string()};
+	Message start_message{0, 0, MsgType::START, {}};
+	EXPECT_CALL(*m_client_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{meta_message, start_message}));
+	client_game->poll();
+	ASSERT_TRUE(client_game->switches().ingame);
+	EXPECT_EQ(0, client_game->input_delay());
+
+	const Input input{PlayerInput{1, 0, GameButton::SWAP, ButtonAction::DOWN}};
+	EXPECT_CALL(*m_client_channel, send(_)).Times(1);
+	client_game->game_input(input);
+	client_game->synchronurse(4); // the input comes back 4 ticks later
+
+	Message input_message{0, 0, MsgType::INPUT, std::string(input)};
+	EXPECT_CALL(*m_client_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{input_message}));
+	client_game->poll();
+	EXPECT_LE(4, client_game->input_delay());
+	EXPECT_GE(MAX_INPUT_DELAY, client_game->input_delay());
+
+	rules.input_delay = 3;
+	local_game->game_reset(2, rules, false);
+	EXPECT_EQ(3, local_game->input_delay());
+}
+
+/**
+ * The ClientGame must report the state of its connection to the server.
+ */
+TEST_F(GameTest, ClientGameConnection)
+{
+	EXPECT_CALL(*m_client_channel, connection()).Times(2)
+		.WillOnce(Return(Connection::CONNECTING))
+		.WillOnce(Return(Connection::FAILED));
+
+	EXPECT_EQ(Connection::CONNECTING, client_game->connection());
+	EXPECT_EQ(Connection::FAILED, client_game->connection());
+	EXPECT_EQ(Connection::CONNECTED, local_game->connection());
+}
+
 /**
  * When we tell the ServerGame to @c game_reset(), it must call the registered handler.
  */
@@ -232,6 +303,33 @@ TEST_F(GameTest, ServerGameRetract)
 	EXPECT_EQ(m_server_factory->m_journal_ptr->inputs().size(), 1); // PlayerInput remains
 }
 
+/**
+ * The ServerGame declares old ticks final at a checkpoint and announces it.
+ * A late input from before the horizon takes effect right after it.
+ */
+TEST_F(GameTest, ServerGameFinalize)
+{
+	const Rules rules;
+	server_game->game_reset(2, rules, false);
+	server_game->game_start();
+
+	const long horizon = 2 * CHECKPOINT_INTERVAL; // latest checkpoint at least FINALIZE_DELAY old
+	const long target_time = horizon + FINALIZE_DELAY;
+	auto matches_finalize = [horizon] (Message m) { return MsgType::FINALIZE == m.type && std::to_string(horizon) == m.data; };
+	auto matches_late = [horizon] (Message m) { return MsgType::INPUT == m.type && Input{m.data}.game_time() == horizon + 1; };
+	EXPECT_CALL(*m_server_channel, send(_)).Times(testing::AnyNumber());
+	EXPECT_CALL(*m_server_channel, send(Truly(matches_finalize))).Times(1);
+	EXPECT_CALL(*m_server_channel, send(Truly(matches_late))).Times(1);
+
+	for(long t = 1; t <= target_time; t++)
+		server_game->synchronurse(t);
+
+	EXPECT_EQ(horizon, m_server_factory->m_journal_ptr->horizon());
+
+	server_game->game_input(Input{PlayerInput{horizon - 5, 0, GameButton::SWAP, ButtonAction::DOWN}});
+	EXPECT_EQ(horizon + 1, m_server_factory->m_journal_ptr->inputs().back().game_time());
+}
+
 /**
  * The @c synchronurse function changes the state to the target time, even if
  * the target is in the past.
@@ -248,6 +346,208 @@ TEST_F(GameTest, SynchronurseBackwards)
 	EXPECT_EQ(m_server_factory->m_state_ptr->game_time(), 1);
 }
 
+/**
+ * When a late input arrives, @c synchronurse rolls back only to the tick
+ * before, using the recent checkpoints.
+ */
+TEST_F(GameTest, SynchronurseRecentCheckpoint)
+{
+	const Rules rules;
+	server_game->game_reset(2, rules, false);
+	server_game->game_start();
+
+	server_game->synchronurse(5);
+	EXPECT_EQ(4, m_server_factory->m_journal_ptr->checkpoint_before(5).game_time());
+
+	server_game->game_input(Input{PlayerInput{5, 0, GameButton::RIGHT, ButtonAction::DOWN}});
+
+	auto matches_retract = [] (Message m)  { return MsgType::RETRACT == m.type && "4" == m.data; };
+	EXPECT_CALL(*m_server_channel, send(Truly(matches_retract))).Times(1);
+
+	server_game->synchronurse(5); // tick 5 -> retract everything after tick 4
+	EXPECT_EQ(5, m_server_factory->m_state_ptr->game_time());
+	EXPECT_EQ(4, m_server_factory->m_journal_ptr->checkpoint_before(5).game_time());
+}
+
+/**
+ * The game publishes a snapshot of its state after every @c synchronurse.
+ * Snapshots taken earlier remain unaffected by later simulation.
+ */
+TEST_F(GameTest, SynchronursePublishesSnapshot)
+{
+	const Rules rules;
+	server_game->game_reset(2, rules, false);
+	EXPECT_EQ(nullptr, server_game->snapshot().get());
+
+	server_game->game_start();
+	const auto initial = server_game->snapshot().get();
+	ASSERT_NE(nullptr, initial);
+	EXPECT_EQ(0, initial->game_time());
+
+	server_game->synchronurse(2); // forward
+	EXPECT_EQ(2, server_game->snapshot().get()->game_time());
+	server_game->synchronurse(1); // backward
+	EXPECT_EQ(1, server_game->snapshot().get()->game_time());
+	EXPECT_EQ(0, initial->game_time());
+
+	server_game->game_reset(2, rules, false);
+	EXPECT_EQ(nullptr, server_game->snapshot().get());
+	EXPECT_EQ(0, initial->game_time()); // still alive
+}
+
+/**
+ * The snapshot after a @c synchronurse is the journal's recent checkpoint of
+ * the same tick, not another copy.
+ */
+TEST_F(GameTest, SnapshotSharesRecentCheckpoint)
+{
+	const Rules rules;
+	server_game->game_reset(2, rules, false);
+	const SnapshotHandle& snapshot = server_game->snapshot();
+	server_game->game_start();
+
+	server_game->synchronurse(5);
+	const auto latest = snapshot.get();
+	ASSERT_NE(nullptr, latest);
+	EXPECT_EQ(5, latest->game_time());
+	EXPECT_EQ(latest.get(), &server_game->journal().checkpoint_before(6));
+}
+
+namespace
+{
+
+/**
+ * Counts the cursor moves which arrive at the observer.
+ */
+class CursorCounter : public evt::IEventObserver
+{
+
+public:
+
+	virtual void fire(evt::CursorMoves moved) override { count++; }
+
+	int count = 0;
+
+};
+
+}
+
+/**
+ * A game with a feed shares its snapshots and events with the feed.
+ */
+TEST_F(GameTest, SynchronurseFeedsObserver)
+{
+	auto feed = std::make_shared<GameFeed>();
+	server_game->set_feed(feed);
+
+	const Rules rules;
+	server_game->game_reset(2, rules, false);
+	server_game->game_start();
+	EXPECT_EQ(server_game->snapshot().get(), feed->snapshot.get());
+
+	server_game->game_input(Input{PlayerInput{1, 0, GameButton::RIGHT, ButtonAction::DOWN}});
+	server_game->synchronurse(2);
+	EXPECT_EQ(server_game->snapshot().get(), feed->snapshot.get()); // shared, not copied
+
+	CursorCounter counter;
+	feed->events.replay(counter);
+	EXPECT_EQ(1, counter.count);
+	feed->events.replay(counter); // nothing new
+	EXPECT_EQ(1, counter.count);
+
+	server_game->game_reset(2, rules, false);
+	EXPECT_EQ(nullptr, feed->snapshot.get());
+}
+
+/**
+ * The HostGame shows the game from the feed and does not simulate it itself.
+ */
+TEST_F(GameTest, HostGameShowsFeed)
+{
+	auto feed = std::make_shared<GameFeed>();
+	auto channel = std::make_unique<MockChannel>();
+	MockChannel& host_channel = *channel;
+	auto factory = std::make_unique<TestingGameFactory>();
+	TestingGameFactory& host_factory = *factory;
+	HostGame host_game{ move(factory), std::make_unique<ClientProtocol>(move(channel)), feed };
+
+	Message meta_message{0, 0, MsgType::META, GameMeta{2, 0, false}.to_string()};
+	Message start_message{0, 0, MsgType::START, {}};
+	EXPECT_CALL(host_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{meta_message, start_message}));
+	host_game.poll();
+	ASSERT_TRUE(host_game.switches().ingame);
+	EXPECT_EQ(&feed->snapshot, &host_game.snapshot());
+
+	// the server game simulates and fires an event
+	const Rules rules;
+	GameState server_state{GameMeta{2, 0, false, rules}};
+	server_state.update();
+	feed->snapshot.publish(server_state);
+	feed->events.fire(evt::CursorMoves{{1, 0}});
+
+	CursorCounter counter;
+	host_game.hub().subscribe(counter);
+	host_game.synchronurse(1);
+
+	EXPECT_EQ(1, counter.count);
+	EXPECT_EQ(1, host_game.snapshot().get()->game_time());
+	EXPECT_EQ(0, host_factory.m_state_ptr->game_time()); // no simulation of its own
+	host_game.hub().unsubscribe(counter);
+}
+
+/**
+ * In adaptive mode, the HostGame measures the round trip of its inputs by the
+ * time of the server game, because its own state never advances.
+ */
+TEST_F(GameTest, HostGameInputDelay)
+{
+	auto feed = std::make_shared<GameFeed>();
+	auto channel = std::make_unique<MockChannel>();
+	MockChannel& host_channel = *channel;
+	HostGame host_game{ std::make_unique<TestingGameFactory>(), std::make_unique<ClientProtocol>(move(channel)), feed };
+
+	Rules rules;
+	rules.input_delay = INPUT_DELAY_AUTO;
+	Message meta_message{0, 0, MsgType::META, GameMeta{2, 0, false, rules}.to_string()};
+	Message start_message{0, 0, MsgType::START, {}};
+	EXPECT_CALL(host_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{meta_message, start_message}));
+	host_game.poll();
+	ASSERT_TRUE(host_game.switches().ingame);
+
+	GameState server_state{GameMeta{2, 0, false, rules}};
+	const auto advance_server = [&server_state, &feed](int ticks)
+	{
+		for(int i = 0; i < ticks; i++)
+			server_state.update();
+		feed->snapshot.publish(server_state);
+	};
+
+	// the server game takes 4 ticks to send the input back
+	const Input input{PlayerInput{1, 0, GameButton::SWAP, ButtonAction::DOWN}};
+	EXPECT_CALL(host_channel, send(_)).Times(21);
+	host_game.game_input(input);
+	advance_server(4);
+
+	Message input_message{0, 0, MsgType::INPUT, std::string(input)};
+	EXPECT_CALL(host_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{input_message}));
+	host_game.poll();
+	const int raised_delay = host_game.input_delay();
+	EXPECT_LE(4, raised_delay);
+
+	// immediate round trips let the delay fall again as the server game advances
+	for(long time = 10; time < 30; time++) {
+		advance_server(1);
+		const Input fast_input{PlayerInput{time, 0, GameButton::SWAP, ButtonAction::DOWN}};
+		host_game.game_input(fast_input);
+
+		Message fast_message{0, 0, MsgType::INPUT, std::string(fast_input)};
+		EXPECT_CALL(host_channel, poll()).Times(1).WillOnce(Return(std::vector<Message>{fast_message}));
+		host_game.poll();
+	}
+
+	EXPECT_GT(raised_delay, host_game.input_delay());
+}
+
 /**
  * When we use the @c synchronurse function to advance the game state, it must
  * be able to pick up additional inputs generated during execution of game
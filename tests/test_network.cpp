@@ -3,8 +3,10 @@
  */
 
 #include "network.hpp"
+#include "spsc_queue.hpp"
 #include "input.hpp"
 #include "tests_common.hpp"
+#include <thread>
 
 using testing::Truly;
 
@@ -101,12 +103,42 @@ TEST_F(NetworkTest, MessageSerialization)
 	EXPECT_EQ(m.data, "50");
 }
 
+/**
+ * Tests whether encoding and decoding reuse the storage of their targets.
+ */
+TEST(MessageTest, EncodeDecodeInPlace)
+{
+	std::string buffer(64, ' ');
+	const char* buffer_storage = buffer.data();
+	Message{-1, 2, MsgType::INPUT, "50 1 LEFT DOWN"}.encode(buffer);
+	EXPECT_EQ("-1 2 INPUT 50 1 LEFT DOWN", buffer);
+	EXPECT_EQ(buffer_storage, buffer.data());
+
+	Message m{0, 0, MsgType::START, std::string(64, ' ')};
+	const char* data_storage = m.data.data();
+	m.decode(buffer);
+	EXPECT_EQ(-1, m.sender);
+	EXPECT_EQ(2, m.recipient);
+	EXPECT_EQ(MsgType::INPUT, m.type);
+	EXPECT_EQ("50 1 LEFT DOWN", m.data);
+	EXPECT_EQ(data_storage, m.data.data());
+
+	m.decode("3 4 FINALIZE"); // no payload
+	EXPECT_EQ(MsgType::FINALIZE, m.type);
+	EXPECT_EQ("", m.data);
+
+	EXPECT_THROW(m.decode(""), GameException);
+	EXPECT_THROW(m.decode("3 4"), GameException);
+	EXPECT_THROW(m.decode("3 x START "), GameException);
+	EXPECT_THROW(m.decode("3 4 UNKNOWN 1"), GameException);
+}
+
 /**
  * Tests whether the ServerProtocol correctly passes the meta message.
  */
 TEST_F(NetworkTest, ServerProtocolMeta)
 {
-	const Rules rules;
+	const Rules rules{0, INPUT_DELAY_AUTO};
 	GameMeta meta{3, 1234, false, rules, 1};
 	m_server_protocol->meta(meta);
 
@@ -118,6 +150,7 @@ TEST_F(NetworkTest, ServerProtocolMeta)
 			1234 == m.seed &&
 			false == m.replay &&
 			0 == m.rules.cursor_delay &&
+			INPUT_DELAY_AUTO == m.rules.input_delay &&
 			1 == m.winner;
 	};
 	EXPECT_CALL(recipient, meta(Truly(matches_meta))).Times(1);
@@ -263,3 +296,304 @@ TEST_F(NetworkTest, ClientProtocolStart)
 
 	m_server_protocol->poll(recipient);
 }
+
+/**
+ * The queue passes elements in order and refuses them when full.
+ */
+TEST(SpscQueueTest, Bounded)
+{
+	SpscQueue<int, 4> queue;
+	EXPECT_TRUE(queue.empty());
+	EXPECT_FALSE(queue.pop().has_value());
+
+	for(int i = 0; i < 4; i++)
+		EXPECT_TRUE(queue.push(i));
+
+	int extra = 4;
+	EXPECT_FALSE(queue.push(extra));
+	EXPECT_EQ(0, queue.pop());
+	EXPECT_TRUE(queue.push(extra));
+
+	for(int i = 1; i <= 4; i++)
+		EXPECT_EQ(i, queue.pop());
+
+	EXPECT_TRUE(queue.empty());
+}
+
+/**
+ * The queue passes all elements from one thread to another in order.
+ */
+TEST(SpscQueueTest, Threads)
+{
+	const int COUNT = 10000;
+	SpscQueue<std::string, 16> queue;
+
+	std::thread producer{[&queue] {
+		for(int i = 0; i < COUNT; i++) {
+			std::string element = std::to_string(i);
+			while(!queue.push(element))
+				std::this_thread::yield();
+		}
+	}};
+
+	int expected = 0;
+	while(expected < COUNT) {
+		if(std::optional<std::string> element = queue.pop()) {
+			ASSERT_EQ(std::to_string(expected), *element);
+			expected++;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+
+	producer.join();
+	EXPECT_TRUE(queue.empty());
+}
+
+/**
+ * Elements passed by exchange return to the other side.
+ */
+TEST(SpscQueueTest, Exchange)
+{
+	SpscQueue<std::string, 1> queue;
+	std::string element = "first";
+	std::string consumed = "consumed";
+
+	EXPECT_TRUE(queue.push_exchange(element));
+	EXPECT_FALSE(queue.push_exchange(element));
+	EXPECT_TRUE(queue.pop_exchange(consumed));
+	EXPECT_EQ("first", consumed);
+	EXPECT_FALSE(queue.pop_exchange(consumed));
+
+	element = "second";
+	EXPECT_TRUE(queue.push_exchange(element));
+	EXPECT_EQ("consumed", element);
+}
+
+namespace
+{
+
+/**
+ * Channel that returns all sent messages from the next poll.
+ * It throws when asked to send a message of type BYE.
+ */
+class EchoChannel : public IChannel
+{
+
+public:
+
+	virtual void send(Message message) override
+	{
+		if(MsgType::BYE == message.type)
+			throw GameException("Echo failed.");
+
+		m_buffer.push_back(std::move(message));
+	}
+
+	virtual std::vector<Message> poll() override
+	{
+		std::vector<Message> messages;
+		swap(m_buffer, messages);
+		return messages;
+	}
+
+private:
+
+	std::vector<Message> m_buffer;
+
+};
+
+/**
+ * Channel that records all sent messages and flushes in a log that outlives it.
+ */
+class RecordChannel : public IChannel
+{
+
+public:
+
+	struct Record
+	{
+		std::vector<Message> sent;
+		int flushes = 0;
+	};
+
+	explicit RecordChannel(std::shared_ptr<Record> record) : m_record(move(record)) {}
+
+	virtual void send(Message message) override
+	{
+		m_record->sent.push_back(std::move(message));
+	}
+
+	virtual std::vector<Message> poll() override
+	{
+		return {};
+	}
+
+	virtual void flush() override
+	{
+		m_record->flushes++;
+	}
+
+private:
+
+	std::shared_ptr<Record> m_record;
+
+};
+
+/**
+ * Poll the channel until the expected number of messages has arrived or
+ * one second has passed.
+ */
+std::vector<Message> poll_for(IChannel& channel, size_t count)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+	std::vector<Message> messages;
+
+	while(messages.size() < count && std::chrono::steady_clock::now() < deadline) {
+		channel.wait_until(deadline);
+		for(Message& message : channel.poll())
+			messages.push_back(std::move(message));
+	}
+
+	return messages;
+}
+
+}
+
+/**
+ * The threaded channel sends and receives through the inner channel on its I/O thread.
+ */
+TEST(ThreadedChannelTest, RoundTrip)
+{
+	auto channel = make_threaded_channel(std::make_unique<EchoChannel>());
+
+	channel->send(Message{0, 0, MsgType::START, {}});
+	channel->send(Message{0, 0, MsgType::INPUT, "50 1 LEFT DOWN"});
+
+	const std::vector<Message> messages = poll_for(*channel, 2);
+	ASSERT_EQ(2, messages.size());
+	EXPECT_EQ(MsgType::START, messages[0].type);
+	EXPECT_EQ(MsgType::INPUT, messages[1].type);
+	EXPECT_EQ("50 1 LEFT DOWN", messages[1].data);
+}
+
+/**
+ * Messages sent right before the channel goes away still reach the inner
+ * channel, which is flushed last.
+ */
+TEST(ThreadedChannelTest, SendBeforeDestruction)
+{
+	auto record = std::make_shared<RecordChannel::Record>();
+	auto channel = make_threaded_channel(std::make_unique<RecordChannel>(record));
+
+	for(int i = 0; i < 10; i++)
+		channel->send(Message{0, 0, MsgType::INPUT, std::to_string(i)});
+
+	channel->send(Message{0, 0, MsgType::GAMEEND, "0"});
+	channel.reset();
+
+	ASSERT_EQ(11, record->sent.size());
+	EXPECT_EQ("9", record->sent[9].data);
+	EXPECT_EQ(MsgType::GAMEEND, record->sent[10].type);
+	EXPECT_EQ(1, record->flushes);
+}
+
+/**
+ * An error on the I/O thread surfaces in the owner's thread.
+ */
+TEST(ThreadedChannelTest, Error)
+{
+	auto channel = make_threaded_channel(std::make_unique<EchoChannel>());
+
+	channel->send(Message{0, 0, MsgType::BYE, {}});
+	EXPECT_THROW(poll_for(*channel, 1), GameException);
+}
+
+/**
+ * Polling into a vector overwrites its front and keeps the other elements.
+ */
+TEST(ThreadedChannelTest, PollInto)
+{
+	auto channel = make_threaded_channel(std::make_unique<EchoChannel>());
+	std::vector<Message> messages(3, Message{0, 0, MsgType::BYE, {}});
+
+	channel->send(Message{0, 0, MsgType::SPEED, "2"});
+
+	size_t count = 0;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+	while(0 == count && std::chrono::steady_clock::now() < deadline) {
+		channel->wait_until(deadline);
+		count = channel->poll_into(messages);
+	}
+
+	ASSERT_EQ(1, count);
+	ASSERT_EQ(3, messages.size());
+	EXPECT_EQ(MsgType::SPEED, messages[0].type);
+	EXPECT_EQ("2", messages[0].data);
+	EXPECT_EQ(MsgType::BYE, messages[2].type);
+}
+
+/**
+ * The conditioned channel holds back messages in both directions for the latency.
+ */
+TEST(ConditionedChannelTest, Latency)
+{
+	std::chrono::steady_clock::time_point now{};
+	NetConditions conditions;
+	conditions.latency = 100;
+	auto channel = make_conditioned_channel(std::make_unique<EchoChannel>(), conditions, 1, [&now] { return now; });
+
+	channel->send(Message{0, 0, MsgType::START, {}});
+	now += std::chrono::milliseconds{99};
+	EXPECT_TRUE(channel->poll().empty()); // not yet sent
+	now += std::chrono::milliseconds{1};
+	EXPECT_TRUE(channel->poll().empty()); // sent and echoed, but not yet received
+	now += std::chrono::milliseconds{100};
+	EXPECT_EQ(1, channel->poll().size());
+}
+
+/**
+ * In reliable mode, the messages arrive complete and in order despite
+ * jitter, reordering and loss.
+ */
+TEST(ConditionedChannelTest, Reliable)
+{
+	std::chrono::steady_clock::time_point now{};
+	const NetConditions conditions{10, 50, 20, 20, 50, true};
+	auto channel = make_conditioned_channel(std::make_unique<EchoChannel>(), conditions, 1, [&now] { return now; });
+
+	const int COUNT = 100;
+	std::vector<Message> messages;
+	for(int i = 0; i < COUNT; i++) {
+		channel->send(Message{0, 0, MsgType::INPUT, std::to_string(i)});
+		now += std::chrono::milliseconds{5};
+		for(Message& message : channel->poll())
+			messages.push_back(std::move(message));
+	}
+
+	for(int i = 0; i < COUNT; i++) {
+		now += std::chrono::seconds{1};
+		for(Message& message : channel->poll())
+			messages.push_back(std::move(message));
+	}
+
+	ASSERT_EQ(COUNT, messages.size());
+	for(int i = 0; i < COUNT; i++)
+		EXPECT_EQ(std::to_string(i), messages[i].data);
+}
+
+/**
+ * In unreliable mode, duplicated messages arrive more than once.
+ */
+TEST(ConditionedChannelTest, Duplication)
+{
+	std::chrono::steady_clock::time_point now{};
+	NetConditions conditions;
+	conditions.duplication = 100;
+	conditions.reliable = false;
+	auto channel = make_conditioned_channel(std::make_unique<EchoChannel>(), conditions, 1, [&now] { return now; });
+
+	channel->send(Message{0, 0, MsgType::START, {}});
+	EXPECT_EQ(4, channel->poll().size()); // duplicated on the way out and again on the way back
+}
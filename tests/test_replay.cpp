@@ -50,7 +50,7 @@ TEST_F(ReplayTest, WriteJournal)
 
 	std::string expected =
 R"(start
-meta 2 4711 false 0 1
+meta 2 4711 false 0 1 0
 input PlayerInput 3 0 left press
 input PlayerInput 5 1 up press
 input PlayerInput 8 0 raise press
@@ -114,6 +114,87 @@ TEST_F(ReplayTest, Checkpoint)
 	EXPECT_EQ(3, journal->checkpoint_before(4).game_time());
 }
 
+/**
+ * Test that recent Journal checkpoints are preferred while they last
+ * and become obsolete with new inputs.
+ */
+TEST_F(ReplayTest, RecentCheckpoint)
+{
+	for(size_t i = 0; i < RECENT_CHECKPOINTS + 2; i++) {
+		state->update();
+		journal->add_recent_checkpoint(*state);
+	}
+
+	const long last = static_cast<long>(RECENT_CHECKPOINTS) + 2;
+	EXPECT_EQ(last - 1, journal->checkpoint_before(last).game_time());
+	EXPECT_EQ(3, journal->checkpoint_before(4).game_time());
+	EXPECT_EQ(0, journal->checkpoint_before(2).game_time()); // recent ring has moved on
+
+	// late input invalidates the recent checkpoints from its time
+	journal->add_input(Input{PlayerInput{last - 1, 0, GameButton::SWAP, ButtonAction::DOWN}});
+	EXPECT_EQ(last - 2, journal->checkpoint_before(last).game_time());
+
+	// retraction invalidates the recent checkpoints after its time
+	journal->retract(last - 4);
+	EXPECT_EQ(last - 4, journal->checkpoint_before(last).game_time());
+}
+
+/**
+ * Test that a new recent checkpoint reuses the storage of the expired one,
+ * unless someone still holds on to it.
+ */
+TEST_F(ReplayTest, RecentCheckpointReuse)
+{
+	std::vector<const GameState*> storage;
+	std::shared_ptr<const GameState> held;
+
+	for(size_t i = 0; i < RECENT_CHECKPOINTS; i++) {
+		state->update();
+		const auto checkpoint = journal->add_recent_checkpoint(*state);
+		storage.push_back(checkpoint.get());
+		if(1 == i)
+			held = checkpoint;
+	}
+
+	state->update();
+	const auto reused = journal->add_recent_checkpoint(*state);
+	EXPECT_EQ(storage[0], reused.get());
+	EXPECT_EQ(state->game_time(), reused->game_time());
+
+	state->update();
+	const auto fresh = journal->add_recent_checkpoint(*state);
+	EXPECT_NE(storage[1], fresh.get());
+	EXPECT_EQ(2, held->game_time()); // untouched
+	EXPECT_EQ(state->game_time(), fresh->game_time());
+}
+
+/**
+ * Test that the finalized Journal keeps the latest checkpoint at or before
+ * the horizon and rejects changes up to the horizon.
+ */
+TEST_F(ReplayTest, Finalize)
+{
+	for(int i = 0; i < 3; i++) {
+		for(long t = 0; t < CHECKPOINT_INTERVAL; t++)
+			state->update();
+		journal->add_checkpoint(GameState(*state));
+	}
+
+	const long horizon = 2 * CHECKPOINT_INTERVAL - 1;
+	journal->finalize(horizon);
+	EXPECT_EQ(horizon, journal->horizon());
+	EXPECT_EQ(CHECKPOINT_INTERVAL, journal->checkpoint_before(horizon + 1).game_time());
+	EXPECT_EQ(3 * CHECKPOINT_INTERVAL, journal->checkpoint_before(3 * CHECKPOINT_INTERVAL + 1).game_time());
+
+	EXPECT_THROW(journal->add_input(Input{PlayerInput{horizon, 0, GameButton::SWAP, ButtonAction::DOWN}}), EnforceException);
+	EXPECT_THROW(journal->retract(horizon - 1), EnforceException);
+	EXPECT_THROW(journal->finalize(horizon - 1), EnforceException);
+
+	// changes after the horizon roll back no further than the base checkpoint
+	journal->add_input(Input{PlayerInput{horizon + 1, 0, GameButton::SWAP, ButtonAction::DOWN}});
+	EXPECT_EQ(CHECKPOINT_INTERVAL, journal->checkpoint_before(3 * CHECKPOINT_INTERVAL + 1).game_time());
+}
+
 /**
  * Test that the Journal properly discovers inputs
  */
@@ -143,6 +224,29 @@ TEST_F(ReplayTest, DiscoverInputs)
 	EXPECT_EQ(2, earliest);
 }
 
+/**
+ * Test that the Journal orders inputs for the same time by their source,
+ * regardless of the order of arrival.
+ */
+TEST_F(ReplayTest, OrderBySource)
+{
+	std::array<Color, PIT_COLS> colors;
+	colors.fill(Color::BLUE);
+
+	const Input late{PlayerInput{2, 1, GameButton::SWAP, ButtonAction::DOWN}};
+	const Input press{PlayerInput{2, 0, GameButton::LEFT, ButtonAction::DOWN}};
+	const Input release{PlayerInput{2, 0, GameButton::LEFT, ButtonAction::UP}};
+	const Input spawn{SpawnBlockInput{2, 0, 1, colors}};
+
+	journal->add_input(late);
+	journal->add_input(press);
+	journal->add_input(release);
+	journal->add_input(spawn);
+
+	const Inputs expected{spawn, press, release, late};
+	EXPECT_EQ(expected, journal->inputs());
+}
+
 /**
  * Test that the Journal retracts the correct kinds of inputs.
  */
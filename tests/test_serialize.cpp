@@ -0,0 +1,136 @@
+/**
+ * Tests for the binary representation of game objects.
+ */
+
+#include "serialize.hpp"
+#include "state.hpp"
+#include "error.hpp"
+#include "tests_common.hpp"
+
+class SerializeTest : public ::testing::Test
+{
+
+public:
+
+	explicit SerializeTest()
+	{
+		GameMeta meta{ 2,0 };
+		state = std::make_unique<GameState>(meta);
+
+		Pit& pit = *state->pit().at(0);
+		pit.set_floor(10);
+		pit.spawn_block(Color::BLUE, RowCol{ 1,0 }, Block::State::REST);
+		Block& block = pit.spawn_block(Color::ORANGE, RowCol{ 1,1 }, Block::State::REST);
+		block.chaining = true;
+		block.set_state(Block::State::BREAK, BREAK_TIME);
+		pit.spawn_block(Color::RED, RowCol{ 2,0 }, Block::State::PREVIEW);
+		Garbage& garbage = pit.spawn_garbage(RowCol{ -2,0 }, 3, 1, Loot{Color::GREEN, Color::PURPLE, Color::YELLOW});
+		garbage.set_state(Physical::State::FALL, ROW_HEIGHT, FALL_SPEED);
+		pit.cursor_move(Dir::LEFT);
+
+		state->update();
+		state->update();
+	}
+
+protected:
+
+	std::unique_ptr<GameState> state;
+	std::array<std::byte, 1024> buffer;
+
+};
+
+/**
+ * Tests that a decoded state is identical to the encoded state.
+ */
+TEST_F(SerializeTest, RoundTrip)
+{
+	BinaryWriter writer{buffer.data(), buffer.size()};
+	state->encode(writer);
+	ASSERT_FALSE(writer.overflow());
+
+	BinaryReader reader{buffer.data(), writer.size()};
+	const GameState decoded = GameState::decode(reader);
+
+	EXPECT_EQ(0, reader.remaining());
+	const auto diff = state->diff(decoded);
+	EXPECT_FALSE(diff) << diff->to_string();
+}
+
+/**
+ * Tests that the rules of the pits survive the round trip.
+ */
+TEST_F(SerializeTest, RoundTripRules)
+{
+	GameMeta meta{ 2,0 };
+	meta.rules.cursor_delay = 4;
+	meta.rules.input_delay = INPUT_DELAY_AUTO;
+	const GameState original{meta};
+
+	BinaryWriter writer{buffer.data(), buffer.size()};
+	original.encode(writer);
+	ASSERT_FALSE(writer.overflow());
+
+	BinaryReader reader{buffer.data(), writer.size()};
+	const GameState decoded = GameState::decode(reader);
+
+	const auto diff = original.diff(decoded);
+	EXPECT_FALSE(diff) << diff->to_string();
+
+	meta.rules.input_delay = 0;
+	const auto rules_diff = original.diff(GameState{meta});
+	ASSERT_TRUE(rules_diff);
+	EXPECT_EQ("rules.input_delay", rules_diff->field);
+}
+
+/**
+ * Tests that the writer reports the required size if the buffer is too small.
+ */
+TEST_F(SerializeTest, Overflow)
+{
+	BinaryWriter writer{buffer.data(), buffer.size()};
+	state->encode(writer);
+	const size_t required = writer.size();
+
+	BinaryWriter small_writer{buffer.data(), required - 1};
+	state->encode(small_writer);
+	EXPECT_TRUE(small_writer.overflow());
+	EXPECT_EQ(required, small_writer.size());
+}
+
+/**
+ * Tests that incomplete or unknown data is rejected.
+ */
+TEST_F(SerializeTest, DecodeInvalid)
+{
+	BinaryWriter writer{buffer.data(), buffer.size()};
+	state->encode(writer);
+
+	BinaryReader truncated{buffer.data(), writer.size() - 1};
+	EXPECT_THROW(GameState::decode(truncated), SerializeException);
+
+	buffer[0] = std::byte{GameState::FORMAT_VERSION + 1};
+	BinaryReader wrong_version{buffer.data(), writer.size()};
+	EXPECT_THROW(GameState::decode(wrong_version), SerializeException);
+}
+
+/**
+ * Tests the encoding of signed varints at the limits.
+ */
+TEST(BinaryTest, SignedVarint)
+{
+	std::array<std::byte, 64> buffer;
+	const std::int64_t values[] = {0, -1, 1, 63, -64, 64, INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX};
+
+	BinaryWriter writer{buffer.data(), buffer.size()};
+	for(std::int64_t value : values)
+		writer.put_signed(value);
+
+	ASSERT_FALSE(writer.overflow());
+	EXPECT_EQ(5 * 1 + 2 + 2 * 5 + 2 * 10, writer.size()); // small magnitudes take few bytes
+
+	BinaryReader reader{buffer.data(), writer.size()};
+	for(std::int64_t value : values)
+		EXPECT_EQ(value, reader.get_signed());
+
+	EXPECT_EQ(0, reader.remaining());
+}
@@ -0,0 +1,115 @@
+/**
+ * Long randomized soak tests over the headless simulation.
+ * Every test runs once per seed, so that the test runner can spread them
+ * over all cores.
+ */
+
+#include "director.hpp"
+#include "state.hpp"
+#include "tests_common.hpp"
+
+namespace
+{
+
+const int SOAK_GAMES = 10; //!< number of games in one random play test
+const long MAX_GAME_TICKS = 10 * 60 * TPS; //!< upper limit on the length of one game
+const long LOCKSTEP_TICKS = 20000; //!< length of the determinism test, beyond the end of the game
+const long RESUME_TIME = 30 * TPS; //!< copy the state during the game, at this time
+
+/**
+ * Verify that every object in the pit lies within the pit columns and
+ * can be found at its own location.
+ */
+void expect_consistent(const Pit& pit)
+{
+	for(const auto& physical : pit.contents()) {
+		const RowCol rc = physical->rc();
+		ASSERT_LE(0, rc.c);
+		ASSERT_GE(PIT_COLS, rc.c + physical->columns());
+		ASSERT_EQ(physical.get(), pit.at(rc));
+	}
+}
+
+}
+
+class SimulationTest : public ::testing::TestWithParam<unsigned>
+{
+};
+
+/**
+ * Tests that random play keeps the pits consistent until the game ends.
+ */
+TEST_P(SimulationTest, RandomPlay)
+{
+	for(int game = 0; game < SOAK_GAMES; game++) {
+		const unsigned seed = GetParam() * SOAK_GAMES + game;
+		Simulation simulation{seed};
+		std::minstd_rand generator{seed};
+
+		while(simulation.state().game_time() < MAX_GAME_TICKS && !simulation.director().over()) {
+			simulation.random_inputs(generator);
+			simulation.step();
+
+			for(const auto& pit : simulation.state().pit())
+				expect_consistent(*pit);
+
+			if(HasFatalFailure())
+				FAIL() << "Inconsistent pit with seed " << seed << " at time " << simulation.state().game_time();
+		}
+
+		EXPECT_TRUE(simulation.director().over()) << "Endless game with seed " << seed;
+	}
+}
+
+/**
+ * Tests that two simulations with the same seed and inputs never diverge.
+ */
+TEST_P(SimulationTest, Deterministic)
+{
+	Simulation lhs{GetParam()};
+	Simulation rhs{GetParam()};
+	std::minstd_rand lhs_generator{GetParam()};
+	std::minstd_rand rhs_generator{GetParam()};
+
+	auto step_lhs = [&lhs, &lhs_generator]() { lhs.random_inputs(lhs_generator); lhs.step(); };
+	auto step_rhs = [&rhs, &rhs_generator]() { rhs.random_inputs(rhs_generator); rhs.step(); };
+
+	const auto diff = diff_lockstep(lhs.state(), step_lhs, rhs.state(), step_rhs, LOCKSTEP_TICKS);
+	EXPECT_FALSE(diff) << diff->to_string();
+}
+
+/**
+ * Tests that a simulation which resumes from a copy of the state
+ * continues exactly like the original.
+ */
+TEST_P(SimulationTest, ResumeFromCopy)
+{
+	Simulation simulation{GetParam()};
+	std::minstd_rand generator{GetParam()};
+	simulation.run(RESUME_TIME, generator);
+	ASSERT_FALSE(simulation.director().over());
+
+	GameState copy{simulation.state()};
+	const long resume_time = copy.game_time();
+	simulation.run(MAX_GAME_TICKS, generator);
+
+	// replay the recorded inputs and arbiter decisions on the copy
+	BlockDirector director;
+	evt::GameEventHub hub; // no arbiter, its decisions are in the journal
+	director.set_state(copy);
+	director.set_handler(hub);
+	while(copy.game_time() < simulation.state().game_time()) {
+		InputSpan inputs = simulation.journal().get_inputs(copy.game_time() + 1);
+		for(auto it = inputs.first; it != inputs.second; ++it)
+			director.apply_input(*it);
+
+		copy.update();
+		director.update();
+	}
+
+	ASSERT_LT(resume_time, copy.game_time());
+	const auto diff = copy.diff(simulation.state());
+	EXPECT_FALSE(diff) << diff->to_string();
+}
+
+INSTANTIATE_TEST_SUITE_P(Seeds, SimulationTest, ::testing::Range(1u, 9u));
@@ -2,7 +2,6 @@
  * Tests for behavior of game objects.
  */
 
-#include "stage.hpp"
 #include "error.hpp"
 #include "tests_common.hpp"
 
@@ -447,3 +446,127 @@ TEST_F(StateTest, RaiseSuppressesRecovery)
 	pit->replenish_recovery();
 	EXPECT_EQ(0., pit->recovery());
 }
+
+/**
+ * Tests that the state diff finds nothing in a copy and then reports
+ * the first differing field of a physical.
+ */
+TEST_F(StateTest, Diff)
+{
+	pit->spawn_block(Color::BLUE, RowCol{ 1,0 }, Block::State::REST);
+	Block& block = pit->spawn_block(Color::RED, RowCol{ 1,1 }, Block::State::REST);
+
+	GameState copy{*state};
+	EXPECT_FALSE(state->diff(copy));
+
+	block.col = Color::GREEN;
+	const auto diff = state->diff(copy);
+
+	ASSERT_TRUE(diff);
+	EXPECT_EQ(0, diff->game_time);
+	EXPECT_EQ(0, diff->pit);
+	EXPECT_EQ(1, diff->object);
+	EXPECT_EQ("col", diff->field);
+	EXPECT_EQ(color_to_string(Color::GREEN), diff->lhs);
+	EXPECT_EQ(color_to_string(Color::RED), diff->rhs);
+}
+
+/**
+ * Tests that the state diff reports physicals of different types by name.
+ */
+TEST_F(StateTest, DiffKind)
+{
+	GameState other{*state};
+	pit->spawn_block(Color::BLUE, RowCol{ 1,0 }, Block::State::REST);
+	other.pit().at(0)->spawn_garbage(RowCol{ 1,0 }, 3, 1, rainbow_loot(3));
+
+	const auto diff = state->diff(other);
+
+	ASSERT_TRUE(diff);
+	EXPECT_EQ(0, diff->object);
+	EXPECT_EQ("kind", diff->field);
+	EXPECT_EQ("Block", diff->lhs);
+	EXPECT_EQ("Garbage", diff->rhs);
+}
+
+/**
+ * Tests that assigning a state yields an equal state, which keeps its
+ * objects where they are of the same type and has a consistent content map.
+ */
+TEST_F(StateTest, AssignReusesObjects)
+{
+	Block& kept = pit->spawn_block(Color::BLUE, RowCol{ 1,0 }, Block::State::REST);
+	pit->spawn_block(Color::RED, RowCol{ 1,1 }, Block::State::REST);
+	pit->spawn_block(Color::RED, RowCol{ 1,2 }, Block::State::REST);
+
+	GameState other{*state};
+	Pit& other_pit = *other.pit().at(0);
+	other_pit.spawn_block(Color::RED, RowCol{ 1,3 }, Block::State::REST); // different count
+	other_pit.block_at(RowCol{ 1,0 })->col = Color::GREEN; // different field
+	other.update();
+
+	GameState copy{*state};
+	copy.pit().at(0)->spawn_garbage(RowCol{ -2,0 }, 3, 1, rainbow_loot(3)); // different type at index 3
+
+	*state = other;
+	EXPECT_FALSE(state->diff(other));
+	EXPECT_EQ(&kept, pit->block_at(RowCol{ 1,0 })); // same object, new values
+	EXPECT_EQ(Color::GREEN, kept.col);
+
+	copy = other;
+	EXPECT_FALSE(copy.diff(other));
+	EXPECT_FALSE(copy.pit().at(0)->at(RowCol{ -2,0 })); // the garbage is gone from the map
+	EXPECT_TRUE(copy.pit().at(0)->block_at(RowCol{ 1,3 }));
+}
+
+/**
+ * Tests that the lockstep comparison stops at the first tick of divergence.
+ */
+TEST_F(StateTest, DiffLockstep)
+{
+	GameState other{*state};
+	auto step_state = [this]() { state->update(); };
+	auto step_other = [&other]() { other.update(); };
+
+	EXPECT_FALSE(diff_lockstep(*state, step_state, other, step_other, 10));
+	EXPECT_EQ(10, state->game_time());
+
+	auto step_swerve = [&other]() {
+		other.update();
+		if(13 == other.game_time())
+			other.pit()[1]->cursor_move(Dir::LEFT);
+	};
+	const auto diff = diff_lockstep(*state, step_state, other, step_swerve, 20);
+
+	ASSERT_TRUE(diff);
+	EXPECT_EQ(13, diff->game_time);
+	EXPECT_EQ(1, diff->pit);
+	EXPECT_EQ(StateDiff::NO_OBJECT, diff->object);
+	EXPECT_EQ("cursor.dir", diff->field);
+}
+
+/**
+ * Tests that a snapshot handle copies new states into the storage of an
+ * earlier snapshot once no reader holds it anymore.
+ */
+TEST_F(StateTest, SnapshotReusesStorage)
+{
+	SnapshotHandle handle;
+	handle.publish(*state);
+	const GameState* first = handle.get().get();
+
+	state->update();
+	handle.publish(*state);
+	auto held = handle.get(); // a reader keeps the second snapshot
+
+	state->update();
+	handle.publish(*state);
+	EXPECT_EQ(first, handle.get().get());
+	EXPECT_EQ(2, handle.get()->game_time());
+
+	state->update();
+	handle.publish(*state);
+	EXPECT_NE(held.get(), handle.get().get());
+	EXPECT_EQ(1, held->game_time()); // unchanged while held
+	EXPECT_EQ(3, handle.get()->game_time());
+}
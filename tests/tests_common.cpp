@@ -8,17 +8,13 @@
 #include "replay.hpp"
 #include "context.hpp"
 #include "configuration.hpp"
-#include "asset.hpp"
 #include "audio.hpp"
 #include "error.hpp"
 
 void configure_context_for_testing()
 {
 	// Destroy any leftover context from previous test runs.
-	// This is especially important for objects that own an only-once resource (e.g. SDL)
-	the_context.sdl.reset();
 	the_context.log.reset();
-	the_context.assets.reset();
 	the_context.audio.reset();
 
 	Configuration configuration;
@@ -31,9 +27,7 @@ void configure_context_for_testing()
 	configuration.server_url = {};
 
 	the_context.configuration.reset(new Configuration(std::move(configuration)));
-	the_context.sdl.reset(new Sdl(0));
 	the_context.log = create_no_log();
-	the_context.assets.reset(new NoAssets);
 	the_context.audio.reset(new NoAudio);
 }
 
@@ -96,6 +90,62 @@ void prefill_pit(Pit& pit)
 }
 
 
+Simulation::Simulation(unsigned seed, int players)
+{
+	LocalGameFactory factory;
+	factory.create(GameMeta{players, seed, false, Rules{}, NOONE});
+
+	m_state = factory.state();
+	m_journal = factory.journal();
+	m_director = factory.director();
+	m_hub = factory.hub();
+	m_arbiter = factory.arbiter();
+	m_held.resize(players, GameButton::NONE);
+}
+
+void Simulation::input(int player, GameButton button, ButtonAction action)
+{
+	m_journal->add_input(Input{PlayerInput{m_state->game_time() + 1, player, button, action}});
+}
+
+void Simulation::random_inputs(std::minstd_rand& generator)
+{
+	std::uniform_int_distribution<int> chance{0, 3};
+	std::uniform_int_distribution<int> button{static_cast<int>(GameButton::LEFT), static_cast<int>(GameButton::SWAP)};
+
+	for(int player = 0; player < static_cast<int>(m_held.size()); player++) {
+		if(0 != chance(generator))
+			continue;
+
+		if(GameButton::NONE != m_held[player])
+			input(player, m_held[player], ButtonAction::UP);
+
+		m_held[player] = static_cast<GameButton>(button(generator));
+		input(player, m_held[player], ButtonAction::DOWN);
+	}
+}
+
+void Simulation::step()
+{
+	InputSpan inputs = m_journal->get_inputs(m_state->game_time() + 1);
+	for(auto it = inputs.first; it != inputs.second; ++it)
+		m_director->apply_input(*it);
+
+	m_state->update();
+	m_director->update();
+}
+
+long Simulation::run(long end_time, std::minstd_rand& generator)
+{
+	while(m_state->game_time() < end_time && !m_director->over()) {
+		random_inputs(generator);
+		step();
+	}
+
+	return m_state->game_time();
+}
+
+
 void TestChannel::add_recipient(TestChannel& channel)
 {
 	m_recipients.push_back(&channel);
@@ -4,11 +4,12 @@
  */
 #pragma once
 
-#include "stage.hpp"
 #include "arbiter.hpp"
 #include "director.hpp"
 #include "network.hpp"
-#include "draw.hpp"
+#include "game.hpp"
+#include "replay.hpp"
+#include <random>
 
 #pragma warning(push)
 #pragma warning(disable : 26451)
@@ -53,6 +54,58 @@ bool swap_at(Pit& pit, BlockDirector& director, RowCol rc);
  */
 void prefill_pit(Pit& pit);
 
+/**
+ * Headless simulation for long-running tests.
+ * It steps the @c GameState with its @c BlockDirector and a seeded
+ * @c LocalArbiter directly, without the checkpoints, snapshots and logging
+ * of a full game and without any drawing or audio.
+ */
+class Simulation
+{
+
+public:
+
+	explicit Simulation(unsigned seed, int players = 2);
+
+	GameState& state() noexcept { return *m_state; }
+	BlockDirector& director() noexcept { return *m_director; }
+	Journal& journal() noexcept { return *m_journal; }
+
+	/**
+	 * Record a button action of the given player for the next tick.
+	 */
+	void input(int player, GameButton button, ButtonAction action);
+
+	/**
+	 * Record random button actions for the next tick.
+	 * Each player acts with a probability of one in four, releasing the
+	 * button held since the last action and pressing a new one.
+	 * The players never raise their pits, which would end the games early.
+	 */
+	void random_inputs(std::minstd_rand& generator);
+
+	/**
+	 * Run one tick of the game, including all inputs recorded for it.
+	 */
+	void step();
+
+	/**
+	 * Run the game with random inputs until it is over or the end time is reached.
+	 * @return the game time at the end
+	 */
+	long run(long end_time, std::minstd_rand& generator);
+
+private:
+
+	std::unique_ptr<GameState> m_state;
+	std::unique_ptr<Journal> m_journal;
+	std::unique_ptr<BlockDirector> m_director;
+	std::unique_ptr<evt::GameEventHub> m_hub;
+	std::unique_ptr<IArbiter> m_arbiter; //!< subscribed to the hub for random spawns
+	std::vector<GameButton> m_held; //!< random button held by each player
+
+};
+
 /**
  * A shortcut implementation of a network channel for testing purposes.
  * It simply forwards all messages to one or more other @c TestChannels,
@@ -91,6 +144,7 @@ public:
 
 	MOCK_METHOD(void, send, (Message message), (override));
 	MOCK_METHOD(std::vector<Message>, poll, (), (override));
+	MOCK_METHOD(Connection, connection, (), (const, override));
 };
 
 /**
@@ -104,6 +158,7 @@ public:
 	MOCK_METHOD(void, meta, (GameMeta meta), (override));
 	MOCK_METHOD(void, input, (Input input), (override));
 	MOCK_METHOD(void, retract, (long cutoff_time), (override));
+	MOCK_METHOD(void, finalize, (long horizon), (override));
 	MOCK_METHOD(void, speed, (int speed), (override));
 	MOCK_METHOD(void, start, (), (override));
 	MOCK_METHOD(void, gameend, (int winner), (override));
@@ -139,23 +194,3 @@ public:
 	MOCK_METHOD(void, fire, (evt::Starve starve), (override));
 
 };
-
-class MockDraw : public IDraw
-{
-
-public:
-
-	MOCK_METHOD(void, gfx, (int x, int y, Gfx gfx, size_t frame, uint8_t a), (override));
-	MOCK_METHOD(void, gfx_rotate, (int x, int y, double angle, Gfx gfx, size_t frame, uint8_t a), (override));
-	MOCK_METHOD(void, rect, (wrap::Rect rect, wrap::Color color), (override));
-	MOCK_METHOD(void, line, (int x1, int y1, int x2, int y2, wrap::Color color), (override));
-	MOCK_METHOD(void, highlight, (wrap::Rect rect, wrap::Color color), (override));
-	MOCK_METHOD(void, text, (int x, int y, const TtfText& text), (override));
-	MOCK_METHOD(void, text_fixed, (int x, int y, const BitmapFont& font, const char* text), (override));;
-	MOCK_METHOD(void, clip, (wrap::Rect rect), (override));
-	MOCK_METHOD(void, unclip, (), (override));
-	MOCK_METHOD(std::unique_ptr<ICanvas>, create_canvas, (), (override));
-	MOCK_METHOD(void, reset_target, (), (override));
-	MOCK_METHOD(void, render, (), (override));
-
-};
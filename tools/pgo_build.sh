@@ -0,0 +1,58 @@
+#!/bin/sh
+# Build the core, server, tools and benchmarks with profile-guided and
+# link-time optimization, then compare the result to a plain release build.
+#
+# Usage: tools/pgo_build.sh [replay directory]
+#
+# 1. An instrumented build plays computer self-play games and all replays
+#    in the replay directory (default: the benchmark corpus) to collect
+#    execution profiles.
+# 2. The final build in the same directory optimizes with these profiles
+#    and with link-time optimization.
+# 3. The self-play benchmark runs on both the plain and the final build.
+#
+# Environment: BUILD_DIR, BASE_DIR, TRAIN_GAMES, BENCH_GAMES, JOBS.
+
+set -e
+
+SOURCE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-$SOURCE_DIR/build-pgo}
+BASE_DIR=${BASE_DIR:-$SOURCE_DIR/build-release}
+PROFILE_DIR=$BUILD_DIR/profile
+REPLAY_DIR=${1:-$SOURCE_DIR/benchmarks/corpus}
+TRAIN_GAMES=${TRAIN_GAMES:-20}
+BENCH_GAMES=${BENCH_GAMES:-20}
+TRAIN_SEED=1000 # train on different games than we measure
+JOBS=${JOBS:-$(nproc 2>/dev/null || echo 2)}
+OPTIONS="-DCMAKE_BUILD_TYPE=Release -DSHITBRIX_BUILD_CLIENT=OFF"
+
+echo "== Instrumented build"
+rm -rf "$PROFILE_DIR"
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" $OPTIONS -DSHITBRIX_LTO=OFF -DSHITBRIX_PGO=GENERATE -DSHITBRIX_PGO_DIR="$PROFILE_DIR"
+cmake --build "$BUILD_DIR" -j "$JOBS"
+
+echo "== Training"
+"$BUILD_DIR/shitbrix-bench-selfplay" "$TRAIN_GAMES" "$TRAIN_SEED"
+if [ -n "$REPLAY_DIR" ]; then
+	for replay in "$REPLAY_DIR"/*.txt; do
+		"$BUILD_DIR/shitbrix-replay" "$replay" > /dev/null
+	done
+fi
+
+# Clang writes raw profiles which must be merged before use.
+if ls "$PROFILE_DIR"/*.profraw > /dev/null 2>&1; then
+	llvm-profdata merge -output="$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "== Optimized build"
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" $OPTIONS -DSHITBRIX_LTO=ON -DSHITBRIX_PGO=USE -DSHITBRIX_PGO_DIR="$PROFILE_DIR"
+cmake --build "$BUILD_DIR" -j "$JOBS"
+
+echo "== Reference build"
+cmake -S "$SOURCE_DIR" -B "$BASE_DIR" $OPTIONS
+cmake --build "$BASE_DIR" -j "$JOBS"
+
+echo "== Benchmark: release"
+"$BASE_DIR/shitbrix-bench-selfplay" "$BENCH_GAMES"
+echo "== Benchmark: PGO + LTO"
+"$BUILD_DIR/shitbrix-bench-selfplay" "$BENCH_GAMES"
@@ -0,0 +1,190 @@
+/**
+ * Benchmark corpus recorder.
+ * Computer players play many candidate games with fixed seeds. From these,
+ * the recorder picks games which represent different workloads and writes
+ * them as replays into the corpus directory.
+ *
+ * The replays, not the seeds, make up the corpus, so that changes to the
+ * computer players do not change the benchmark workload.
+ *
+ * Usage: shitbrix-record_corpus [corpus directory] [candidates]
+ */
+
+#include "game.hpp"
+#include "director.hpp"
+#include "agent.hpp"
+#include "replay.hpp"
+#include "event.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+const char* DEFAULT_DIRECTORY = "benchmarks/corpus";
+const int DEFAULT_CANDIDATES = 16; //!< number of games per agent setup
+const long MAX_TICKS = 15 * 60 * TPS; //!< upper limit on the length of one game
+
+/**
+ * Reaction times of the computer players in the candidate games.
+ * Unequal players make short games, equal players long ones.
+ */
+const std::vector<std::vector<int>> AGENT_SETUPS = {
+	{2, 2}, {2, 4}, {3, 3}, {2, 8}, {6, 6}
+};
+
+/**
+ * Outcome and statistics of one candidate game.
+ */
+struct Candidate
+{
+	std::string setup; //!< description of the players
+	std::string replay; //!< complete record of the game in replay format
+	long ticks; //!< length of the game
+	int garbage; //!< number of garbage bricks dropped
+	int deepest_chain; //!< highest chain counter
+	int chains; //!< number of chains
+};
+
+/**
+ * Collects the statistics of a game from its events.
+ */
+class CandidateObserver : public evt::IEventObserver
+{
+
+public:
+
+	int deepest_chain = 0;
+	int chains = 0;
+
+	virtual void fire(evt::Chain chained) override
+	{
+		deepest_chain = std::max(deepest_chain, chained.counter);
+		chains++;
+	}
+
+};
+
+/**
+ * Play one game to its end with one computer player per delay value.
+ */
+Candidate play_game(unsigned seed, const std::vector<int>& delays)
+{
+	const int players = static_cast<int>(delays.size());
+	LocalGame game{std::make_unique<LocalGameFactory>()};
+	game.set_seed(seed);
+	game.game_reset(players, Rules{}, false);
+	game.game_start();
+
+	CandidateObserver observer;
+	game.hub().subscribe(observer);
+
+	std::vector<Agent> agents;
+	for(int i = 0; i < players; i++)
+		agents.emplace_back(game.snapshot(), i, delays[i]);
+
+	for(long time = 1; time <= MAX_TICKS && !game.director().over(); time++) {
+		for(Agent& agent : agents) {
+			for(const PlayerInput pi : agent.move())
+				game.game_input(Input{pi});
+		}
+
+		game.synchronurse(time);
+	}
+
+	std::string setup = "seed " + std::to_string(seed) + ", delays";
+	for(int delay : delays)
+		setup += " " + std::to_string(delay);
+
+	const Inputs& inputs = game.journal().inputs();
+	const int garbage = static_cast<int>(std::count_if(inputs.begin(), inputs.end(),
+		[](const Input& input) {
+			return input.visit([](const auto& i) { return std::is_same_v<const SpawnGarbageInput&, decltype(i)>; });
+		}));
+
+	std::ostringstream replay;
+	replay_stream(replay, game.journal());
+
+	return Candidate{setup, replay.str(), game.state().game_time(), garbage, observer.deepest_chain, observer.chains};
+}
+
+/**
+ * Remove and return the candidate which ranks highest by the given measure.
+ */
+template<typename Measure>
+Candidate pick(std::vector<Candidate>& candidates, Measure measure)
+{
+	enforce(!candidates.empty());
+
+	const auto best = std::max_element(candidates.begin(), candidates.end(),
+		[&measure](const Candidate& lhs, const Candidate& rhs) { return measure(lhs) < measure(rhs); });
+	Candidate candidate = std::move(*best);
+	candidates.erase(best);
+	return candidate;
+}
+
+/**
+ * Write the candidate as a replay file into the directory.
+ */
+void write_replay(const std::filesystem::path& directory, const std::string& name, const Candidate& candidate)
+{
+	const std::filesystem::path path = directory / (name + ".txt");
+	std::ofstream stream{path, std::ios::binary};
+	enforce(stream.good());
+	stream << candidate.replay;
+
+	std::printf("%-10s %6ld ticks, %4d garbage, chains %3d up to %d (%s)\n", name.c_str(),
+		candidate.ticks, candidate.garbage, candidate.chains, candidate.deepest_chain, candidate.setup.c_str());
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+	on_failure_break_into_debugger = false; // report errors on the console instead
+
+	try {
+		configure_headless_context(Configuration{}, create_no_log());
+
+		const std::filesystem::path directory = argc > 1 ? argv[1] : DEFAULT_DIRECTORY;
+		const int count = argc > 2 ? std::stoi(argv[2]) : DEFAULT_CANDIDATES;
+		std::filesystem::create_directories(directory);
+
+		std::vector<Candidate> candidates;
+		unsigned seed = 1;
+		for(const auto& delays : AGENT_SETUPS) {
+			for(int i = 0; i < count; i++) {
+				Candidate candidate = play_game(seed++, delays);
+				if(candidate.ticks < MAX_TICKS) // only finished games make reproducible replays
+					candidates.push_back(std::move(candidate));
+			}
+		}
+
+		// The median game must be picked before the longest and shortest are gone.
+		std::sort(candidates.begin(), candidates.end(),
+			[](const Candidate& lhs, const Candidate& rhs) { return lhs.ticks < rhs.ticks; });
+		const long median = candidates.at(candidates.size() / 2).ticks;
+
+		write_replay(directory, "medium", pick(candidates, [median](const Candidate& c) { return -std::abs(c.ticks - median); }));
+		write_replay(directory, "short", pick(candidates, [](const Candidate& c) { return -c.ticks; }));
+		write_replay(directory, "marathon", pick(candidates, [](const Candidate& c) { return c.ticks; }));
+		write_replay(directory, "garbage", pick(candidates, [](const Candidate& c) { return c.garbage * TPS * 60 / c.ticks; }));
+		write_replay(directory, "chain", pick(candidates, [](const Candidate& c) { return c.deepest_chain * 1000 + c.chains; }));
+	}
+	catch(const std::exception& ex) {
+		std::fprintf(stderr, "%s\n", ex.what());
+		return 1;
+	}
+
+	return 0;
+}
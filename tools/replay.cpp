@@ -0,0 +1,63 @@
+/**
+ * Replay tool.
+ * Plays back a replay file without any user interface and prints the outcome.
+ *
+ * Usage: shitbrix-replay <replay file> [max ticks]
+ */
+
+#include "game.hpp"
+#include "director.hpp"
+#include "configuration.hpp"
+#include "context.hpp"
+#include "error.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+/**
+ * Stop the playback after this many ticks if no player has lost until then.
+ */
+const long DEFAULT_MAX_TICKS = 60 * 60 * TPS;
+
+}
+
+int main(int argc, const char* argv[])
+{
+	if(argc < 2) {
+		std::fprintf(stderr, "Usage: %s <replay file> [max ticks]\n", argv[0]);
+		return 2;
+	}
+
+	on_failure_break_into_debugger = false; // report errors on the console instead
+
+	try {
+		configure_headless_context(Configuration{}, create_no_log());
+
+		const long max_ticks = argc > 2 ? std::stol(argv[2]) : DEFAULT_MAX_TICKS;
+
+		LocalGame game{std::make_unique<LocalGameFactory>()};
+		game.load_replay(argv[1]);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for(long time = 1; time <= max_ticks && !game.director().over(); time++)
+			game.synchronurse(time);
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		const long ticks = game.state().game_time();
+
+		std::printf("ticks:   %ld\n", ticks);
+		std::printf("winner:  %d\n", game.director().winner());
+		std::printf("seconds: %.3f\n", elapsed.count());
+		std::printf("ticks/s: %.0f\n", ticks / elapsed.count());
+	}
+	catch(const std::exception& ex) {
+		std::fprintf(stderr, "%s\n", ex.what());
+		return 1;
+	}
+
+	return 0;
+}
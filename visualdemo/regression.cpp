@@ -0,0 +1,317 @@
+/**
+ * Headless visual regression test, see render_scenes.
+ */
+
+#include "visualdemo.hpp"
+#include "stage.hpp"
+#include "replay.hpp"
+#include "error.hpp"
+#include <SDL_image.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/**
+ * All game ticks at which to capture one replay.
+ */
+struct ReplayScenes
+{
+	std::filesystem::path replay;
+	std::vector<long> ticks; //!< in ascending order
+};
+
+/**
+ * Read the scene file. Each line names a replay, followed by the ticks to capture.
+ * Empty lines and lines starting with # are ignored.
+ */
+std::vector<ReplayScenes> read_scenes(const char* path)
+{
+	std::ifstream stream{path};
+	if(!stream)
+		throwx<GameException>("Cannot read scene file %s.", path);
+
+	std::vector<ReplayScenes> scenes;
+	std::string line;
+
+	while(std::getline(stream, line)) {
+		if(line.empty() || '#' == line[0])
+			continue;
+
+		std::istringstream tokens{line};
+		std::string replay;
+		tokens >> replay;
+		ReplayScenes replay_scenes{replay, {}};
+		for(long tick; tokens >> tick;)
+			replay_scenes.ticks.push_back(tick);
+
+		std::sort(replay_scenes.ticks.begin(), replay_scenes.ticks.end());
+		if(!replay.empty())
+			scenes.push_back(std::move(replay_scenes));
+	}
+
+	return scenes;
+}
+
+/**
+ * Hands the stages from the replay threads to the drawing thread.
+ * SDL can only draw in the thread which owns the renderer. Meanwhile, the
+ * replay thread waits, so that its stage does not change during drawing.
+ */
+class SceneQueue
+{
+
+public:
+
+	explicit SceneQueue(int workers) noexcept : m_workers(workers) {}
+
+	/**
+	 * Worker side: have the stage drawn and wait until it is done.
+	 */
+	void capture(std::string name, const Stage& stage)
+	{
+		std::promise<void> drawn;
+		std::future<void> done = drawn.get_future();
+
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_requests.push_back(Request{std::move(name), &stage, std::move(drawn)});
+		}
+
+		m_condition.notify_one();
+		done.get();
+	}
+
+	/**
+	 * Worker side: signal that the worker will not capture any more scenes.
+	 */
+	void worker_done()
+	{
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_workers--;
+		}
+
+		m_condition.notify_one();
+	}
+
+	/**
+	 * Drawing side: draw scenes with the given function until all workers are done.
+	 */
+	template<typename Draw>
+	void serve(Draw draw)
+	{
+		for(;;) {
+			std::unique_lock<std::mutex> lock{m_mutex};
+			m_condition.wait(lock, [this] { return !m_requests.empty() || 0 == m_workers; });
+			if(m_requests.empty())
+				return;
+
+			Request request = std::move(m_requests.front());
+			m_requests.pop_front();
+			lock.unlock();
+
+			try {
+				draw(request.name, *request.stage);
+				request.drawn.set_value();
+			}
+			catch(...) {
+				request.drawn.set_exception(std::current_exception());
+			}
+		}
+	}
+
+private:
+
+	struct Request
+	{
+		std::string name;
+		const Stage* stage;
+		std::promise<void> drawn;
+	};
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<Request> m_requests;
+	int m_workers; //!< number of workers which may still capture scenes
+
+};
+
+/**
+ * Play back the replay and capture the scenes at the requested ticks.
+ * The stage receives the same updates as in the game screen.
+ */
+void play_scenes(const ReplayScenes& scenes, IDraw& draw, SceneQueue& queue)
+{
+	LocalGame game{std::make_unique<LocalGameFactory>()};
+	game.load_replay(scenes.replay);
+
+	Stage stage{game.snapshot(), draw};
+	stage.subscribe_to(game.hub());
+	stage.fade(0.f); // skip the intro
+
+	const std::string stem = scenes.replay.stem().u8string();
+	bool over = false;
+	long time = 0;
+
+	for(long tick : scenes.ticks) {
+		while(time < tick) {
+			time++;
+			game.poll();
+			stage.update();
+
+			if(!over && NOONE != game.journal().meta().winner) {
+				over = true;
+				stage.show_result(game.journal().meta().winner);
+			}
+
+			if(!over)
+				game.synchronurse(time);
+		}
+
+		char name[256];
+		std::snprintf(name, sizeof(name), "%s-%05ld", stem.c_str(), tick);
+		queue.capture(name, stage);
+	}
+
+	stage.unsubscribe_from(game.hub());
+}
+
+/**
+ * Hash of the pixel contents of the surface, for a quick comparison between runs.
+ */
+uint32_t pixel_hash(const SDL_Surface& surface) noexcept
+{
+	uint32_t hash = 2166136261u;
+	const auto* pixels = static_cast<const uint8_t*>(surface.pixels);
+	const size_t row_bytes = static_cast<size_t>(surface.w) * surface.format->BytesPerPixel;
+
+	for(int y = 0; y < surface.h; y++) {
+		const uint8_t* row = pixels + static_cast<size_t>(y) * surface.pitch;
+		for(size_t x = 0; x < row_bytes; x++)
+			hash = (hash ^ row[x]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/**
+ * Return the number of pixels which differ between the two surfaces.
+ * Surfaces of different dimensions differ in all pixels.
+ */
+long pixel_difference(const SDL_Surface& actual, SDL_Surface& golden)
+{
+	if(actual.w != golden.w || actual.h != golden.h)
+		return static_cast<long>(actual.w) * actual.h;
+
+	SurfacePtr converted{SDL_ConvertSurfaceFormat(&golden, actual.format->format, 0)};
+	sdlok(converted.get());
+
+	const int bpp = actual.format->BytesPerPixel;
+	long difference = 0;
+
+	for(int y = 0; y < actual.h; y++) {
+		const auto* lhs = static_cast<const uint8_t*>(actual.pixels) + static_cast<size_t>(y) * actual.pitch;
+		const auto* rhs = static_cast<const uint8_t*>(converted->pixels) + static_cast<size_t>(y) * converted->pitch;
+		for(int x = 0; x < actual.w; x++) {
+			if(!std::equal(lhs + x * bpp, lhs + (x + 1) * bpp, rhs + x * bpp))
+				difference++;
+		}
+	}
+
+	return difference;
+}
+
+}
+
+int render_scenes(const Options& options)
+{
+	const std::vector<ReplayScenes> scenes = read_scenes(options.scene_file());
+	const std::filesystem::path golden_dir = options.golden_dir();
+	if(options.update())
+		std::filesystem::create_directories(golden_dir);
+	else if(!std::filesystem::is_directory(golden_dir))
+		throwx<GameException>("Golden image directory %s not found. Create the images with --update.", golden_dir.u8string().c_str());
+
+	SDL_Renderer& renderer = the_context.sdl->renderer();
+	SdlDraw draw{renderer, *the_context.assets};
+	SdlCanvas canvas{the_context.sdl->create_target_texture(), renderer};
+
+	const unsigned concurrency = std::max(1u, std::thread::hardware_concurrency());
+	const int jobs = std::clamp(options.jobs() > 0 ? options.jobs() : static_cast<int>(concurrency), 1, std::max(1, static_cast<int>(scenes.size())));
+
+	SceneQueue queue{jobs};
+	std::atomic<size_t> next_replay{0};
+	std::vector<std::future<void>> workers;
+
+	for(int i = 0; i < jobs; i++) {
+		workers.push_back(std::async(std::launch::async, [&scenes, &draw, &queue, &next_replay] {
+			try {
+				for(size_t r = next_replay++; r < scenes.size(); r = next_replay++)
+					play_scenes(scenes[r], draw, queue);
+			}
+			catch(...) {
+				queue.worker_done();
+				throw;
+			}
+			queue.worker_done();
+		}));
+	}
+
+	int failures = 0;
+
+	queue.serve([&](const std::string& name, const Stage& stage) {
+		canvas.use_as_target();
+		stage.draw(0.f);
+		SurfacePtr actual = canvas.read_pixels();
+
+		const std::filesystem::path golden_path = golden_dir / (name + ".png");
+		const std::filesystem::path actual_path = golden_dir / (name + ".actual.png");
+		const std::string hash = [&actual] { char text[16]; std::snprintf(text, sizeof(text), "%08x", pixel_hash(*actual)); return std::string(text); }();
+		std::string outcome;
+
+		if(options.update()) {
+			sdlok(IMG_SavePNG(actual.get(), golden_path.u8string().c_str()));
+			std::filesystem::remove(actual_path);
+			outcome = "updated";
+		}
+		else if(!std::filesystem::exists(golden_path)) {
+			sdlok(IMG_SavePNG(actual.get(), actual_path.u8string().c_str()));
+			outcome = "NO GOLDEN IMAGE";
+			failures++;
+		}
+		else {
+			SurfacePtr golden = the_context.sdl->load_surface(golden_path.u8string().c_str());
+			const long difference = pixel_difference(*actual, *golden);
+			if(0 == difference) {
+				std::filesystem::remove(actual_path);
+				outcome = "ok";
+			}
+			else {
+				sdlok(IMG_SavePNG(actual.get(), actual_path.u8string().c_str()));
+				outcome = "DIFFERS in " + std::to_string(difference) + " pixels";
+				failures++;
+			}
+		}
+
+		std::printf("%-24s %s  %s\n", name.c_str(), hash.c_str(), outcome.c_str());
+	});
+
+	draw.reset_target();
+
+	for(auto& worker : workers)
+		worker.get(); // propagate errors from replay threads
+
+	return failures;
+}
@@ -1,8 +1,12 @@
 #include "visualdemo.hpp"
 #include "stage.hpp"
 #include "configuration.hpp"
+#include "context.hpp"
+#include "asset.hpp"
+#include "audio.hpp"
 #include "error.hpp"
 #include <cassert>
+#include <cstdio>
 #include <sstream>
 
 namespace
@@ -23,7 +27,7 @@ VisualDemo::VisualDemo() :
 	m_game(make_game()),
 	m_pit(*m_game->state().pit().at(0)),
 	m_draw(new SdlDraw(the_context.sdl->renderer(), *the_context.assets)),
-	m_stage(m_game->state(), *m_draw)
+	m_stage(m_game->snapshot(), *m_draw)
 {
 }
 
@@ -312,8 +316,14 @@ GameState VisualDemo::run_and_checkpoint(long target_time)
 }
 
 Options::Options(int argc, const char* argv[])
-	: m_scenario_nr(int_option(argc, argv, "--scenario"))
+	: m_scenario_nr(int_option(argc, argv, "--scenario")),
+	m_scene_file(str_option(argc, argv, "--render")),
+	m_golden_dir(str_option(argc, argv, "--golden")),
+	m_update(bool_option(argc, argv, "--update")),
+	m_jobs(int_option(argc, argv, "--jobs"))
 {
+	if(nullptr == m_golden_dir)
+		m_golden_dir = "visualdemo/golden";
 }
 
 // Minimalistic opts parsing from http://stackoverflow.com/questions/865668/how-to-parse-command-line-arguments-in-c
@@ -348,6 +358,28 @@ int Options::int_option(int argc, const char* argv[], const std::string& option)
 	return 0;
 }
 
+namespace
+{
+
+/**
+ * Set up the global context for the demo.
+ * Headless, SDL renders into memory only, without a window or audio.
+ */
+void configure_demo_context(const Configuration& configuration, bool headless)
+{
+	the_context.configuration.reset(new Configuration(configuration));
+	the_context.configuration->apply_runtime();
+	the_context.sdl.reset(new Sdl(headless ? SDL_INIT_VIDEO | SDL_INIT_EVENTS : SDL_INIT_EVERYTHING, headless));
+	the_context.log = create_file_log(configuration.log_path);
+	the_context.assets.reset(new FileAssets(*the_context.sdl));
+
+	if(headless)
+		the_context.audio.reset(new NoAudio);
+	else
+		the_context.audio.reset(new SdlAudio(the_context.sdl->audio()));
+}
+
+}
 
 int main(int argc, char* argv[])
 {
@@ -360,7 +392,21 @@ int main(int argc, char* argv[])
 	configuration.autorecord = false;
 	configuration.log_path = "visualdemo.log";
 
-	configure_context(configuration);
+	const bool headless = nullptr != options.scene_file();
+	configure_demo_context(configuration, headless);
+
+	if(headless) {
+		on_failure_break_into_debugger = false; // report errors on the console instead
+
+		try {
+			return render_scenes(options) > 0 ? 1 : 0;
+		}
+		catch(const std::exception& ex) {
+			std::fprintf(stderr, "%s\n", ex.what());
+			return 2;
+		}
+	}
+
 	VisualDemo demo;
 
 	switch(options.scenario_nr()) {
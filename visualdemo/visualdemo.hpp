@@ -6,6 +6,9 @@
  * The implementation uses only the bare basics of infrastructure
  * required to run the game scenario and display it.
  * Supports ESC for quitting, SPACE for pause/unpause, CTRL for framestep.
+ *
+ * With the --render option, the program instead runs headless as a visual
+ * regression test, see @c render_scenes.
  */
 #pragma once
 
@@ -85,9 +88,17 @@ public:
 	Options(int argc, const char* argv[]);
 
 	const int scenario_nr() const noexcept { return m_scenario_nr; }
+	const char* scene_file() const noexcept { return m_scene_file; }
+	const char* golden_dir() const noexcept { return m_golden_dir; }
+	bool update() const noexcept { return m_update; }
+	int jobs() const noexcept { return m_jobs; }
 
 private:
 	const int m_scenario_nr;
+	const char* m_scene_file; //!< list of scenes to render headless, or nullptr
+	const char* m_golden_dir; //!< directory of the reference images
+	bool m_update; //!< replace the reference images instead of comparing
+	int m_jobs; //!< number of replays to simulate in parallel
 
 	// Minimalistic opts parsing from http://stackoverflow.com/questions/865668/how-to-parse-command-line-arguments-in-c
 	const char* str_option(int argc, const char* argv[], const std::string& option);
@@ -95,3 +106,17 @@ private:
 	int int_option(int argc, const char* argv[], const std::string& option);
 
 };
+
+/**
+ * Render scenes from replays headless and compare them to golden images.
+ *
+ * The scene file lists one replay per line, followed by the game ticks at
+ * which to capture the screen. Replays play back in parallel, while the
+ * main thread draws each scene with @c SdlDraw into an offscreen canvas.
+ * The image of scene "<replay>-<tick>" must match the golden image
+ * "<replay>-<tick>.png" in the golden directory pixel by pixel.
+ * On mismatch, the actual image is saved next to it as "<replay>-<tick>.actual.png".
+ *
+ * Return the number of scenes which do not match.
+ */
+int render_scenes(const Options& options);